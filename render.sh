@@ -28,19 +28,22 @@ if [ -z "$BUILD_PROJECT_DIR" ]; then
   exit 1
 fi
 
-EXECUTABLE_PATH="$BUILD_PROJECT_DIR/projects_ray"
-INI_FILE="/inifile/falling_spheres/scene_1.ini"
+# the headless renderer starts faster and needs no display; older builds only have the GUI executable
+EXECUTABLE_PATH="$BUILD_PROJECT_DIR/projects_ray_cli"
+if [ ! -x "$EXECUTABLE_PATH" ] && [ ! -f "$EXECUTABLE_PATH.exe" ]; then
+  EXECUTABLE_PATH="$BUILD_PROJECT_DIR/projects_ray"
+fi
+INI_GLOB="inifiles/falling_spheres/*.ini"
 
-for INI_FILE in inifiles/falling_spheres/*.ini; do
-  if [ -x "$EXECUTABLE_PATH" ] || [ -f "$EXECUTABLE_PATH.exe" ]; then
-    echo "Running $EXECUTABLE_PATH with $INI_FILE"
-    if [ -x "$EXECUTABLE_PATH" ]; then
-      "$EXECUTABLE_PATH" "$INI_FILE"
-    elif [ -f "$EXECUTABLE_PATH.exe" ]; then
-      "$EXECUTABLE_PATH.exe" "$INI_FILE"
-    fi
-  else
-    echo "Error: Executable $EXECUTABLE_PATH not found or is not executable."
-    exit 1
-  fi
-done
+# All frames are rendered by a single process, which expands the glob itself,
+# shares decoded textures between frames and renders frames in parallel
+if [ -x "$EXECUTABLE_PATH" ]; then
+  echo "Running $EXECUTABLE_PATH with $INI_GLOB"
+  "$EXECUTABLE_PATH" "$INI_GLOB"
+elif [ -f "$EXECUTABLE_PATH.exe" ]; then
+  echo "Running $EXECUTABLE_PATH.exe with $INI_GLOB"
+  "$EXECUTABLE_PATH.exe" "$INI_GLOB"
+else
+  echo "Error: Executable $EXECUTABLE_PATH not found or is not executable."
+  exit 1
+fi
@@ -0,0 +1,187 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#include "raytracer/raytracer.h"
+#include "raytracer/raytracescene.h"
+#include "raytracer/scenegeometry.h"
+#include "utils/renderstats.h"
+#include "utils/sceneparser.h"
+
+// the rays per second are the point of the benchmark, so it links a renderer that counts them
+static_assert(RenderStats::enabled(), "projects_ray_bench must be built with RT_ENABLE_STATS");
+
+// One fixed benchmark workload
+struct Workload {
+    QString name;
+    QString scenePath; // relative to the repository root
+    QString lensPath;  // relative to the repository root, or empty
+    bool depthOfField;
+    bool motionBlur;
+};
+
+// The standard scenes, covering each of the renderer's expensive paths
+const std::vector<Workload> WORKLOADS = {
+    {"primitives",     "scenefiles/andys_room.json",      "",                false, false},
+    {"area-lights",    "scenefiles/sphere_line.json",     "",                false, false},
+    {"depth-of-field", "scenefiles/sphere_line.json",     "",                true,  false},
+    {"motion-blur",    "scenefiles/falling_spheres.json", "",                false, true},
+    {"lens",           "scenefiles/andys_room.json",      "lenses/wide.dat", false, false},
+};
+
+// Helper function returning the peak resident memory of the whole process so far in kilobytes, or -1 if unknown
+long long peakMemoryKB() {
+#if defined(__APPLE__)
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024; // bytes on macOS
+#elif defined(__unix__)
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+#else
+    return -1;
+#endif
+}
+
+// Helper function to render one workload and describe how it went
+bool runWorkload(const Workload &workload, const QDir &root, int width, int height, unsigned int seed, int repeat, QJsonObject &result) {
+    RenderData metaData;
+    if (!SceneParser::parseScene(root.filePath(workload.scenePath).toStdString(), metaData)) {
+        std::cerr << "Error loading scene: \"" << workload.scenePath.toStdString() << "\"" << std::endl;
+        return false;
+    }
+    if (!workload.lensPath.isEmpty() &&
+        !SceneParser::parseLens(root.filePath(workload.lensPath).toStdString(), metaData)) {
+        std::cerr << "Error loading lens: \"" << workload.lensPath.toStdString() << "\"" << std::endl;
+        return false;
+    }
+
+    RayTracer::Config config;
+    config.enableDepthOfField = workload.depthOfField;
+    config.enableMotionBlur = workload.motionBlur;
+    config.enableLens = !workload.lensPath.isEmpty();
+
+    RayTraceScene scene{ width, height, metaData };
+    std::vector<RGBA> image(width * height);
+
+    // the best of several runs is the least disturbed by the rest of the machine
+    double bestSeconds = 0.0;
+    RenderStats::Stats stats;
+    for (int run = 0; run < repeat; run++) {
+        std::srand(seed);
+        Camera::seedRandom(seed);
+
+        RenderStats::take();
+        auto start = std::chrono::steady_clock::now();
+        SceneGeometry geometry;
+        geometry.update(scene.getShapes());
+        RayTracer raytracer{ config };
+        raytracer.render(image.data(), scene, geometry);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (run == 0 || seconds < bestSeconds) {
+            bestSeconds = seconds;
+        }
+        stats = RenderStats::take();
+    }
+
+    result["name"] = workload.name;
+    result["scene"] = workload.scenePath;
+    result["width"] = width;
+    result["height"] = height;
+    result["seconds"] = bestSeconds;
+
+    // scene rays: secondary rays are reflections and refractions, and a lens workload's rays through the lens
+    // elements are reported on their own, as each of them is followed by a primary ray into the scene
+    double primary = static_cast<double>(stats.counters[RenderStats::PrimaryRays]);
+    double secondary = static_cast<double>(stats.counters[RenderStats::ReflectionRays] +
+                                           stats.counters[RenderStats::RefractionRays]);
+    double shadow = static_cast<double>(stats.counters[RenderStats::ShadowRays]);
+    double lens = static_cast<double>(stats.counters[RenderStats::LensRays]);
+    result["primaryRays"] = primary;
+    result["secondaryRays"] = secondary;
+    result["shadowRays"] = shadow;
+    result["lensRays"] = lens;
+    result["primaryRaysPerSecond"] = primary / bestSeconds;
+    result["secondaryRaysPerSecond"] = secondary / bestSeconds;
+    result["shadowRaysPerSecond"] = shadow / bestSeconds;
+    result["lensRaysPerSecond"] = lens / bestSeconds;
+    result["raysPerSecond"] = (primary + secondary + shadow) / bestSeconds;
+    return true;
+}
+
+// Renders the standard scenes single-threaded with fixed seeds and prints the timings as JSON
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("projects_ray_bench");
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption rootOption("root", "Repository root the scene files are found in.", "path", ".");
+    QCommandLineOption widthOption("width", "Image width.", "pixels", "256");
+    QCommandLineOption heightOption("height", "Image height.", "pixels", "192");
+    QCommandLineOption seedOption("seed", "Seed of the random samples.", "seed", "1230");
+    QCommandLineOption repeatOption("repeat", "Number of times each scene is rendered; the fastest run is reported.", "count", "1");
+    QCommandLineOption filterOption("scene", "Only run the named workload (may be repeated).", "name");
+    QCommandLineOption outputOption(QStringList{"o", "output"}, "Write the JSON report to this file instead of stdout.", "path");
+    parser.addOptions({rootOption, widthOption, heightOption, seedOption, repeatOption, filterOption, outputOption});
+    parser.process(a);
+
+    QDir root(parser.value(rootOption));
+    int width = parser.value(widthOption).toInt();
+    int height = parser.value(heightOption).toInt();
+    unsigned int seed = parser.value(seedOption).toUInt();
+    int repeat = std::max(parser.value(repeatOption).toInt(), 1);
+    QStringList filter = parser.values(filterOption);
+
+    QJsonArray results;
+    bool success = true;
+    for (const Workload &workload : WORKLOADS) {
+        if (!filter.isEmpty() && !filter.contains(workload.name)) {
+            continue;
+        }
+        std::cerr << "Running " << workload.name.toStdString() << std::endl;
+
+        QJsonObject result;
+        if (!runWorkload(workload, root, width, height, seed, repeat, result)) {
+            success = false;
+            continue;
+        }
+        results.append(result);
+    }
+
+    QJsonObject report;
+    report["seed"] = static_cast<double>(seed);
+    report["repeat"] = repeat;
+    report["workloads"] = results;
+    // the high-water mark of every workload run so far; run one workload (--scene) to measure its own
+    report["processPeakMemoryKB"] = static_cast<double>(peakMemoryKB());
+
+    QByteArray json = QJsonDocument(report).toJson();
+    if (parser.isSet(outputOption)) {
+        QFile file(parser.value(outputOption));
+        if (!file.open(QIODevice::WriteOnly)) {
+            std::cerr << "Error: could not write \"" << parser.value(outputOption).toStdString() << "\"" << std::endl;
+            return 1;
+        }
+        file.write(json);
+    } else {
+        std::cout << json.toStdString();
+    }
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,242 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtx/transform.hpp>
+
+#include "raytracer/raytracescene.h"
+#include "utils/boundingbox.h"
+#include "utils/cone.h"
+#include "utils/cube.h"
+#include "utils/cylinder.h"
+#include "utils/lightmodel.h"
+#include "utils/sphere.h"
+
+struct Ray {
+    glm::vec3 origin;
+    glm::vec3 direction;
+};
+
+// The transforms every primitive is measured under
+struct Transform {
+    QString name;
+    glm::mat4 ctm;
+};
+
+const std::vector<Transform> TRANSFORMS = {
+    {"identity", glm::mat4(1.0f)},
+    {"translate-scale", glm::translate(glm::vec3(1.0f, -2.0f, 3.0f)) * glm::scale(glm::vec3(2.0f))},
+    {"rotate-nonuniform", glm::translate(glm::vec3(-1.0f, 0.5f, 2.0f)) *
+                          glm::rotate(glm::radians(37.0f), glm::normalize(glm::vec3(1.0f, 1.0f, 0.0f))) *
+                          glm::scale(glm::vec3(1.0f, 2.0f, 0.5f))},
+};
+
+// The fractions of rays aimed at the primitive
+const std::vector<float> HIT_FRACTIONS = {0.1f, 0.5f, 0.9f};
+
+// Helper function to make a reproducible set of rays around a transformed unit primitive.
+// Aimed rays pass through the middle of the primitive, which is inside all four primitive types;
+// the others pass the primitive's bounding sphere at a distance.
+std::vector<Ray> makeRays(std::mt19937 &gen, const glm::mat4 &ctm, float hitFraction, int count) {
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> zeroToOne(0.0f, 1.0f);
+
+    glm::vec3 center = glm::vec3(ctm * glm::vec4(0, 0, 0, 1));
+    float radius = 0.0f;
+    for (int i = 0; i < 8; i++) {
+        glm::vec3 corner(i & 1 ? 0.5f : -0.5f, i & 2 ? 0.5f : -0.5f, i & 4 ? 0.5f : -0.5f);
+        radius = std::max(radius, glm::length(glm::vec3(ctm * glm::vec4(corner, 1)) - center));
+    }
+
+    auto randomDirection = [&]() {
+        glm::vec3 v;
+        do {
+            v = glm::vec3(unit(gen), unit(gen), unit(gen));
+        } while (glm::dot(v, v) > 1.0f || glm::dot(v, v) < 1e-4f);
+        return glm::normalize(v);
+    };
+
+    std::vector<Ray> rays;
+    for (int i = 0; i < count; i++) {
+        glm::vec3 origin = center + 5.0f * radius * randomDirection();
+        glm::vec3 target;
+
+        if (zeroToOne(gen) < hitFraction) {
+            target = glm::vec3(ctm * glm::vec4(0.1f * unit(gen), 0.1f * unit(gen), 0.1f * unit(gen), 1));
+        } else {
+            glm::vec3 toCenter = glm::normalize(center - origin);
+            glm::vec3 side = glm::normalize(glm::cross(toCenter, randomDirection()));
+            target = center + 2.0f * radius * side;
+        }
+        rays.push_back(Ray{origin, glm::normalize(target - origin)});
+    }
+    return rays;
+}
+
+// Helper function to time a kernel over a set of inputs until at least minSeconds have passed.
+// @param call Runs the kernel on input i and returns whether it hit.
+QJsonObject timeKernel(const QString &kernel, const QString &variant, int count, double minSeconds,
+                       const std::function<bool(int)> &call) {
+    long long calls = 0;
+    long long hits = 0;
+    double seconds = 0.0;
+
+    auto start = std::chrono::steady_clock::now();
+    while (seconds < minSeconds) {
+        for (int i = 0; i < count; i++) {
+            hits += call(i) ? 1 : 0;
+        }
+        calls += count;
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    QJsonObject result;
+    result["kernel"] = kernel;
+    result["variant"] = variant;
+    result["calls"] = static_cast<double>(calls);
+    result["hitRate"] = static_cast<double>(hits) / calls;
+    result["nsPerCall"] = seconds * 1e9 / calls;
+    result["callsPerSecond"] = calls / seconds;
+    return result;
+}
+
+// Helper function to make a light of the given type near the origin
+SceneLightData makeLight(LightType type) {
+    SceneLightData light{};
+    light.type = type;
+    light.color = glm::vec4(1.0f);
+    light.function = glm::vec3(1.0f, 0.1f, 0.01f);
+    light.pos = glm::vec4(2.0f, 4.0f, 3.0f, 1.0f);
+    light.dir = glm::vec4(glm::normalize(glm::vec3(-2.0f, -4.0f, -3.0f)), 0.0f);
+    light.angle = glm::radians(30.0f);
+    light.penumbra = glm::radians(10.0f);
+    light.width = 1.0f;
+    light.height = 1.0f;
+    return light;
+}
+
+// Measures the primitive intersection, bounding box and shading kernels in isolation and prints
+// nanoseconds per call and calls per second as JSON
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("projects_ray_microbench");
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption raysOption("rays", "Number of rays in each ray set.", "count", "4096");
+    QCommandLineOption timeOption("min-time", "Minimum time spent on each kernel, in milliseconds.", "ms", "200");
+    QCommandLineOption seedOption("seed", "Seed of the ray sets.", "seed", "1230");
+    parser.addOptions({raysOption, timeOption, seedOption});
+    parser.process(a);
+
+    int count = std::max(parser.value(raysOption).toInt(), 1);
+    double minSeconds = parser.value(timeOption).toDouble() / 1000.0;
+    unsigned int seed = parser.value(seedOption).toUInt();
+
+    SceneMaterial material{};
+    material.cAmbient = glm::vec4(0.1f);
+    material.cDiffuse = glm::vec4(0.6f, 0.4f, 0.2f, 1.0f);
+    material.cSpecular = glm::vec4(0.5f);
+    material.shininess = 20.0f;
+
+    using ShapeFactory = std::function<std::unique_ptr<Shape>(const glm::mat4 &)>;
+    const std::vector<std::pair<QString, ShapeFactory>> primitives = {
+        {"Sphere::calcIntersection", [&](const glm::mat4 &ctm) { return std::make_unique<Sphere>(ctm, material, glm::vec3(0.0f), nullptr); }},
+        {"Cube::calcIntersection", [&](const glm::mat4 &ctm) { return std::make_unique<Cube>(ctm, material, glm::vec3(0.0f), nullptr); }},
+        {"Cone::calcIntersection", [&](const glm::mat4 &ctm) { return std::make_unique<Cone>(ctm, material, glm::vec3(0.0f), nullptr); }},
+        {"Cylinder::calcIntersection", [&](const glm::mat4 &ctm) { return std::make_unique<Cylinder>(ctm, material, glm::vec3(0.0f), nullptr); }},
+    };
+
+    QJsonArray results;
+
+    for (const Transform &transform : TRANSFORMS) {
+        for (float hitFraction : HIT_FRACTIONS) {
+            // every kernel sees the same rays for a given transform and hit fraction
+            std::mt19937 gen(seed);
+            std::vector<Ray> rays = makeRays(gen, transform.ctm, hitFraction, count);
+            QString variant = QString("%1, %2% aimed").arg(transform.name).arg(static_cast<int>(hitFraction * 100));
+
+            for (const auto &[kernel, factory] : primitives) {
+                std::unique_ptr<Shape> shape = factory(transform.ctm);
+                results.append(timeKernel(kernel, variant, count, minSeconds, [&](int i) {
+                    glm::vec3 point;
+                    float t;
+                    return shape->calcIntersection(rays[i].origin, rays[i].direction, point, t, 0.0f, 0.0f);
+                }));
+            }
+
+            glm::vec3 boxMin(std::numeric_limits<float>::max()), boxMax(-std::numeric_limits<float>::max());
+            for (int i = 0; i < 8; i++) {
+                glm::vec3 corner(i & 1 ? 0.5f : -0.5f, i & 2 ? 0.5f : -0.5f, i & 4 ? 0.5f : -0.5f);
+                glm::vec3 world = glm::vec3(transform.ctm * glm::vec4(corner, 1));
+                boxMin = glm::min(boxMin, world);
+                boxMax = glm::max(boxMax, world);
+            }
+            BoundingBox box(boxMin, boxMax);
+            results.append(timeKernel("BoundingBox::traces", variant, count, minSeconds, [&](int i) {
+                return box.traces(rays[i].origin, rays[i].direction);
+            }));
+        }
+    }
+
+    // shading inputs: points on a unit sphere seen from random directions
+    RenderData renderData{};
+    renderData.globalData = SceneGlobalData{0.5f, 0.5f, 0.5f, 0.0f, 0.0f};
+    renderData.cameraData.pos = glm::vec4(0, 0, 5, 1);
+    renderData.cameraData.look = glm::vec4(0, 0, -1, 0);
+    renderData.cameraData.up = glm::vec4(0, 1, 0, 0);
+    renderData.cameraData.heightAngle = glm::radians(45.0f);
+    RayTraceScene scene{ 64, 64, renderData };
+
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<glm::vec3> normals, toCamera;
+    for (int i = 0; i < count; i++) {
+        normals.push_back(glm::normalize(glm::vec3(unit(gen), unit(gen), unit(gen)) + glm::vec3(0, 0, 1e-3f)));
+        toCamera.push_back(glm::normalize(glm::vec3(unit(gen), unit(gen), unit(gen)) + glm::vec3(0, 1e-3f, 0)));
+    }
+
+    const std::vector<std::pair<QString, LightType>> lightTypes = {
+        {"point", LightType::LIGHT_POINT},
+        {"directional", LightType::LIGHT_DIRECTIONAL},
+        {"spot", LightType::LIGHT_SPOT},
+    };
+    for (const auto &[name, type] : lightTypes) {
+        SceneLightData light = makeLight(type);
+        results.append(timeKernel("phong", name + " light", count, minSeconds, [&](int i) {
+            glm::vec4 color = phong(scene, normals[i], normals[i], toCamera[i], material, light, glm::vec3(0.0f));
+            return color.r > 0.0f;
+        }));
+    }
+
+    // area lights are shaded one point on the light at a time, with the points drawn beforehand
+    SceneLightData areaLight = makeLight(LightType::LIGHT_AREA);
+    std::vector<LightSample> areaSamples, drawn;
+    for (int i = 0; i < count; i++) {
+        sampleAreaLight(areaLight, normals[i], 1, drawn);
+        areaSamples.push_back(drawn[0]);
+    }
+    results.append(timeKernel("phongSample", "area light", count, minSeconds, [&](int i) {
+        glm::vec4 color = phongSample(scene, normals[i], toCamera[i], material, areaLight, glm::vec3(0.0f), areaSamples[i]);
+        return color.r > 0.0f;
+    }));
+
+    QJsonObject report;
+    report["seed"] = static_cast<double>(seed);
+    report["rays"] = count;
+    report["kernels"] = results;
+    std::cout << QJsonDocument(report).toJson().toStdString();
+
+    return 0;
+}
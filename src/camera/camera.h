@@ -23,17 +23,17 @@ private:
     glm::vec3 m_look;    // Camera position (lookfrom)
     glm::vec3 m_up;    // Camera position (lookfrom)
 
+    // The random generator used for defocus blur.
+    // One generator per thread, since frames may be rendered in parallel
+    static std::mt19937 &randomGenerator() {
+        static thread_local std::random_device rd;
+        static thread_local std::mt19937 gen(rd());
+        return gen;
+    }
+
     // Helper function for defocus blur
     glm::vec3 randomInUnitDisk() const {
-        static std::random_device rd;
-        static std::mt19937 gen(rd());
-        static std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
-
-        while (true) {
-            glm::vec3 p(dis(gen), dis(gen), 0.0f);
-            if (glm::dot(p, p) < 1.0f)
-                return p;
-        }
+        return random_in_unit_disk();
     }
 
 public:
@@ -71,11 +71,13 @@ public:
 
     glm::vec3 getPosition() const { return m_position; }
 
+    // Restarts the calling thread's defocus blur samples from seed, for reproducible renders
+    static void seedRandom(unsigned int seed) { randomGenerator().seed(seed); }
+
     // Helper function to generate random point in unit disk for DOF
     glm::vec3 random_in_unit_disk() const {
-        static std::random_device rd;
-        static std::mt19937 gen(rd());
-        static std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+        std::mt19937 &gen = randomGenerator();
+        std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
 
         while (true) {
             glm::vec3 p(dis(gen), dis(gen), 0.0f);
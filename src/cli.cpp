@@ -0,0 +1,11 @@
+#include <QCoreApplication>
+#include "commandline.h"
+
+// The headless renderer: no GUI platform plugin is loaded, so it runs on machines without a display
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("projects_ray_cli");
+
+    return runCommandLine(a);
+}
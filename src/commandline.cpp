@@ -0,0 +1,74 @@
+#include "commandline.h"
+#include "raytracer/batchrenderer.h"
+#include "utils/tracelog.h"
+
+#include <QCommandLineParser>
+#include <QDir>
+#include <QThread>
+#include <iostream>
+
+int runCommandLine(QCoreApplication &app) {
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addPositionalArgument("config", "Paths of config files (.ini), globs of config files, or manifests (.txt) listing them.", "config...");
+    QCommandLineOption jobsOption(QStringList{"j", "jobs"}, "Maximum number of frames to render in parallel.", "count");
+    parser.addOption(jobsOption);
+    QCommandLineOption traceOption("trace", "Write a timeline of the render phases to this file (Chrome trace event JSON).", "path");
+    parser.addOption(traceOption);
+    QCommandLineOption textureMemoryOption("texture-memory", "Stream textures from disk, keeping at most this many megabytes of them in memory.", "MB");
+    parser.addOption(textureMemoryOption);
+    QCommandLineOption textureCacheOption("texture-cache", "Directory of the pre-tiled texture files streamed textures are read from.", "path",
+                                          QDir(QDir::tempPath()).filePath("projects_ray_textures"));
+    parser.addOption(textureCacheOption);
+    QCommandLineOption textureAtlasOption("texture-atlas", "Pack small textures into shared atlases.");
+    parser.addOption(textureAtlasOption);
+    QCommandLineOption textureCompressionOption("texture-compression", "Keep textures compressed in memory (BC1 or a 256-color palette) where the error stays within this root mean square (0-255).", "rmse");
+    parser.addOption(textureCompressionOption);
+    parser.process(app);
+
+    auto positionalArgs = parser.positionalArguments();
+    if (positionalArgs.size() < 1) {
+        std::cerr << "Not enough arguments. Please provide a path to a config file (.ini) as a command-line argument." << std::endl;
+        return 1;
+    }
+
+    if (parser.isSet(traceOption)) {
+        TraceLog::start();
+    }
+
+    QStringList iniPaths = BatchRenderer::expandInputs(positionalArgs);
+
+    std::vector<RenderJob> jobs;
+    for (const QString &iniPath : iniPaths) {
+        RenderJob job;
+        if (!BatchRenderer::loadJob(iniPath, job)) {
+            return 1;
+        }
+        jobs.push_back(job);
+    }
+
+    // frames run in parallel on spare cores unless told otherwise
+    int threads = parser.isSet(jobsOption) ? parser.value(jobsOption).toInt() : QThread::idealThreadCount();
+
+    BatchRenderer batchRenderer{ threads };
+    if (parser.isSet(textureMemoryOption)) {
+        std::size_t megabytes = std::max(parser.value(textureMemoryOption).toInt(), 1);
+        batchRenderer.setTextureStreaming(megabytes * 1024 * 1024, parser.value(textureCacheOption));
+    }
+    batchRenderer.setTextureAtlases(parser.isSet(textureAtlasOption));
+    if (parser.isSet(textureCompressionOption)) {
+        batchRenderer.setTextureCompression(std::max(parser.value(textureCompressionOption).toFloat(), 0.0f));
+    }
+    int failures = batchRenderer.run(jobs);
+
+    if (parser.isSet(traceOption) && !TraceLog::write(parser.value(traceOption))) {
+        return 1;
+    }
+
+    if (failures > 0) {
+        std::cerr << failures << " of " << jobs.size() << " frames failed to render" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <QCoreApplication>
+
+// Renders the .ini files named on the command line (see BatchRenderer) and returns the exit code.
+// Shared by the GUI executable, when it is given arguments, and the headless projects_ray_cli.
+int runCommandLine(QCoreApplication &app);
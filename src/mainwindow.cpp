@@ -30,6 +30,10 @@
 #include <iostream>
 #include <QSettings>
 
+// number of pre-rendered frames behind each slider and behind the lens buttons
+const int SEQUENCE_FRAMES = 101;
+const int LENS_FRAMES = 3;
+
 MainWindow::MainWindow()
 {
     setWindowTitle("Spirit Sliders: Graphics Final Project");
@@ -118,10 +122,10 @@ MainWindow::MainWindow()
     connect(depthSlider, &QSlider::valueChanged, this, &MainWindow::depthChanged);
     connect(depthBox, static_cast<void(QSpinBox::*)(int)>(&QSpinBox::valueChanged), this, &MainWindow::depthChanged);
     connect(depthSlider, &QSlider::valueChanged, this, [this](int value) {
-        updateImage("sphere_line", value);
+        updateImage("sphere_line", value, SEQUENCE_FRAMES);
     });
 
-    updateImage("sphere_line", 0);
+    updateImage("sphere_line", 0, SEQUENCE_FRAMES);
 
     // motion section
     QLabel *motionLabel = new QLabel();
@@ -152,7 +156,7 @@ MainWindow::MainWindow()
     connect(motionSlider, &QSlider::valueChanged, this, &MainWindow::motionChanged);
     connect(motionBox, static_cast<void(QSpinBox::*)(int)>(&QSpinBox::valueChanged), this, &MainWindow::motionChanged);
     connect(motionSlider, &QSlider::valueChanged, this, [this](int value) {
-        updateImage("falling_spheres", value);
+        updateImage("falling_spheres", value, SEQUENCE_FRAMES);
     });
 
     // lens section
@@ -162,13 +166,13 @@ MainWindow::MainWindow()
     QHBoxLayout *imageLay = new QHBoxLayout();
 
     addRadioButton(imageLay, "Normal", true, [this]{
-        updateImage("andys_room", 0);
+        updateImage("andys_room", 0, LENS_FRAMES);
     });
     addRadioButton(imageLay, "Fish Eye", false, [this]{
-        updateImage("andys_room", 1);
+        updateImage("andys_room", 1, LENS_FRAMES);
     });
     addRadioButton(imageLay, "Wide", false, [this]{
-        updateImage("andys_room", 2);
+        updateImage("andys_room", 2, LENS_FRAMES);
     });
 
     imageBox->setLayout(imageLay);
@@ -206,9 +210,11 @@ MainWindow::MainWindow()
 
     addDoubleSpinBox(depthSettingsLayout, "Aperture:", 0.0, 10.0, 0.1, settings.aperture, 2, [this](double value) {
         settings.aperture = value;
+        refocus();
     });
     addDoubleSpinBox(depthSettingsLayout, "Focal Length:", 0.0, 200.0, 1.0, settings.focalLength, 1, [this](double value) {
         settings.focalLength = value;
+        refocus();
     });
 
     // Motion Panel
@@ -298,6 +304,15 @@ void MainWindow::render(){
 
     RayTraceScene rtScene{ width, height, metaData };
 
+    // Depth of field is captured as a light field once, so later aperture and
+    // focal length changes are synthesized instead of re-rendered
+    if (settings.renderMode == DEPTH) {
+        raytracer.captureLightField(lightField, rtScene);
+        refocus();
+        return;
+    }
+    lightField = LightField();
+
     raytracer.render(data, rtScene);
 
     image->setPixmap(QPixmap::fromImage(myImage));
@@ -316,6 +331,17 @@ void MainWindow::render(){
     // a.exit();
 }
 
+void MainWindow::refocus() {
+    if (lightField.isEmpty() || settings.renderMode != DEPTH) {
+        return;
+    }
+
+    QImage myImage = QImage(lightField.width(), lightField.height(), QImage::Format_RGBX8888);
+    RGBA *data = reinterpret_cast<RGBA *>(myImage.bits());
+    lightField.synthesize(data, settings.aperture, settings.focalLength);
+
+    image->setPixmap(QPixmap::fromImage(myImage));
+}
 
 // ------ FUNCTIONS FOR ADDING UI COMPONENTS ------
 
@@ -382,26 +408,36 @@ void MainWindow::addCheckBox(QBoxLayout *layout, QString text, bool val, auto fu
     connect(box, &QCheckBox::clicked, this, function);
 }
 
-void MainWindow::updateImage(const QString &folder, int value) {
-    // Construct the file path based on the folder and image index
-    QString filePath = QString("/Users/efratavigdor/Desktop/CS1230/graphics-final-project/outputs/%1/output_%2.png")
-                           .arg(folder)
-                           .arg(value + 1);
+QString MainWindow::framePath(const QString &folder, int index) {
+    return QString("/Users/efratavigdor/Desktop/CS1230/graphics-final-project/outputs/%1/output_%2.png")
+        .arg(folder)
+        .arg(index + 1);
+}
 
-    // Create a QImage object and attempt to load the image
-    QImage myImage;
-    if (!myImage.load(filePath)) {
-        std::cout << "Failed to load image: " << filePath.toStdString() << std::endl;
+void MainWindow::updateImage(const QString &folder, int value, int frameCount) {
+    // Decoded frames come from the cache, so scrubbing back over a frame skips the disk and PNG decode
+    QImage myImage = frameCache.get(framePath(folder, value));
+    if (myImage.isNull()) {
         return;
     }
 
-    // Convert the image to RGBX8888 format if needed
-    myImage = myImage.convertToFormat(QImage::Format_RGBX8888);
-
     // Display the image directly from the QImage object
     image->setPixmap(QPixmap::fromImage(myImage));
     image->setFixedSize(myImage.width(), myImage.height());
     update();
+
+    // Decode the frames just around this one in the background, nearest first; the slider moves
+    // a frame or so at a time, so queueing the whole sequence on every change only wastes decodes
+    QStringList neighbors;
+    for (int offset = 1; offset <= PREFETCH_FRAMES; offset++) {
+        if (value + offset < frameCount) {
+            neighbors.append(framePath(folder, value + offset));
+        }
+        if (value - offset >= 0) {
+            neighbors.append(framePath(folder, value - offset));
+        }
+    }
+    frameCache.prefetch(neighbors);
 }
 
 // ------ FUNCTIONS FOR UPDATING SETTINGS ------
@@ -429,15 +465,15 @@ void MainWindow::motionChanged(int newValue) {
 void MainWindow::onTabChanged(int index) {
     switch (index) {
     case 0:
-        updateImage("sphere_line", 0);
+        updateImage("sphere_line", 0, SEQUENCE_FRAMES);
         depthChanged(0);
         break;
     case 1:
-        updateImage("falling_spheres", 0);
+        updateImage("falling_spheres", 0, SEQUENCE_FRAMES);
         motionChanged(0);
         break;
     case 2:
-        updateImage("andys_room", 0);
+        updateImage("andys_room", 0, LENS_FRAMES);
         break;
     default:
         int width = 1024;
@@ -12,6 +12,7 @@
 #include <QBoxLayout>
 
 #include "raytracer/raytracer.h"
+#include "utils/framecache.h"
 
 class MainWindow : public QLabel
 {
@@ -20,6 +21,7 @@ class MainWindow : public QLabel
 public:
     MainWindow();
     void render();
+    void refocus();
 
 private:
     void setupCanvas2D();
@@ -33,6 +35,10 @@ private:
     QSpinBox *depthBox;
     QSpinBox *motionBox;
 
+    FrameCache frameCache;
+    static const int PREFETCH_FRAMES = 4; // frames decoded ahead on each side of the one shown
+    LightField lightField; // last sandbox depth of field capture, refocused as the settings change
+
     void addHeading(QBoxLayout *layout, QString text);
     void addLabel(QBoxLayout *layout, QString text);
     void addRadioButton(QBoxLayout *layout, QString text, bool value, auto function);
@@ -42,9 +48,10 @@ private:
     void addCheckBox(QBoxLayout *layout, QString text, bool value, auto function);
     void addSlider(QSlider *slider, QSpinBox *box, QBoxLayout *layout, QString text, float tick, int min, int max, int value);
     void onTabChanged(int index);
+    QString framePath(const QString &folder, int index);
 
 private slots:
-    void updateImage(const QString &folder, int value);
+    void updateImage(const QString &folder, int value, int frameCount);
     void depthChanged(int newValue);
     void motionChanged(int newValue);
     void onUploadButtonClick();
@@ -0,0 +1,472 @@
+#include "batchrenderer.h"
+#include "raytracescene.h"
+#include "utils/renderstats.h"
+#include "utils/sceneparser.h"
+#include "utils/tracelog.h"
+
+#include <QCollator>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QSettings>
+#include <QTextStream>
+#include <QThreadPool>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <iostream>
+
+// Saves the image, falling back to PNG if the format cannot be deduced from the path
+bool saveImage(const QImage &image, const QString &oImagePath) {
+    RT_STAT_TIMER(Encode);
+    TraceLog::Span span("save image", "io", TraceLog::isEnabled() ? "{\"path\": " + TraceLog::quote(oImagePath.toStdString()) + "}" : "");
+    bool success = image.save(oImagePath);
+    if (!success) {
+        success = image.save(oImagePath, "PNG");
+    }
+    if (success) {
+        std::cout << "Saved rendered image to \"" << oImagePath.toStdString() << "\"" << std::endl;
+    } else {
+        std::cerr << "Error: failed to save image to \"" << oImagePath.toStdString() << "\"" << std::endl;
+    }
+    return success;
+}
+
+// Helper function to read an optional float from the ini file
+std::optional<float> optionalFloat(const QSettings &settings, const QString &key) {
+    if (!settings.contains(key)) {
+        return std::nullopt;
+    }
+    return settings.value(key).toFloat();
+}
+
+// Helper function to report the statistics of a job where its .ini file asked for them
+void reportStats(const RenderJob &job, const RenderStats::Stats &stats) {
+    if (!RenderStats::enabled()) {
+        static std::atomic<bool> warned = false;
+        if (!warned.exchange(true)) {
+            std::cerr << "Warning: statistics were requested but not compiled in; build with -DRT_ENABLE_STATS=ON" << std::endl;
+        }
+        return;
+    }
+
+    if (job.stats == "json") {
+        QString statsPath = job.outputPath + ".stats.json";
+        QFile file(statsPath);
+        if (!file.open(QIODevice::WriteOnly)) {
+            std::cerr << "Error: could not write statistics to \"" << statsPath.toStdString() << "\"" << std::endl;
+            return;
+        }
+        file.write(QByteArray::fromStdString(stats.toJson()));
+    } else {
+        std::cerr << "Statistics for \"" << job.outputPath.toStdString() << "\":\n" << stats.toText();
+    }
+}
+
+// Helper function returning where the cost heatmap of an image is saved: "image.png" becomes "image.cost.png"
+QString costMapPath(const QString &imagePath) {
+    QFileInfo info(imagePath);
+    return info.dir().filePath(info.completeBaseName() + ".cost.png");
+}
+
+// Helper function to map a cost between 0 and 1 to a color going from black through blue, red and yellow to white
+RGBA heatColor(float v) {
+    const glm::vec3 stops[5] = {{0, 0, 0}, {0, 0, 1}, {1, 0, 0}, {1, 1, 0}, {1, 1, 1}};
+    float x = glm::clamp(v, 0.0f, 1.0f) * 4.0f;
+    int i = std::min(static_cast<int>(x), 3);
+    glm::vec3 color = glm::mix(stops[i], stops[i + 1], x - i);
+    return RGBA{static_cast<std::uint8_t>(255 * color.r), static_cast<std::uint8_t>(255 * color.g),
+                static_cast<std::uint8_t>(255 * color.b), 255};
+}
+
+// Helper function to save a cost map as a heatmap image.
+// The colors are scaled to the 99th percentile, so a few outliers don't wash out the rest of the frame;
+// the scale is stored in the image's "cost-scale" text field.
+bool saveCostMap(const std::vector<float> &costs, int width, int height, RayTracer::CostMetric metric,
+                 const QString &imagePath) {
+    std::vector<float> sorted = costs;
+    std::sort(sorted.begin(), sorted.end());
+    float scale = sorted.empty() ? 0.0f : sorted[std::min(sorted.size() - 1, sorted.size() * 99 / 100)];
+    float maximum = sorted.empty() ? 0.0f : sorted.back();
+
+    QImage heatmap(width, height, QImage::Format_RGBX8888);
+    RGBA *data = reinterpret_cast<RGBA *>(heatmap.bits());
+    for (int i = 0; i < width * height; i++) {
+        data[i] = heatColor(scale > 0.0f ? costs[i] / scale : 0.0f);
+    }
+
+    const char *unit = metric == RayTracer::CostMetric::IntersectionTests ? "intersection tests"
+                       : metric == RayTracer::CostMetric::Rays ? "rays" : "ns";
+    heatmap.setText("cost-scale", QString("%1 %2").arg(scale).arg(unit));
+    std::cout << "Pixel cost: 99th percentile " << scale << " " << unit << ", maximum " << maximum << " " << unit << std::endl;
+    return saveImage(heatmap, costMapPath(imagePath));
+}
+
+BatchRenderer::BatchRenderer(int threads)
+    : m_threads(std::max(threads, 1))
+{}
+
+bool BatchRenderer::loadJob(const QString &iniPath, RenderJob &job) {
+    if (!QFileInfo(iniPath).exists()) {
+        std::cerr << "Error: config file not found: \"" << iniPath.toStdString() << "\"" << std::endl;
+        return false;
+    }
+
+    QSettings settings( iniPath, QSettings::IniFormat );
+    job.iniPath = iniPath;
+    job.scenePath = settings.value("IO/scene").toString();
+    job.outputPath = settings.value("IO/output").toString();
+    job.lensPath = settings.value("IO/lens").toString();
+    job.animationPath = settings.value("IO/animation").toString();
+    job.firstFrame = settings.value("Animation/first-frame", 0).toInt();
+    job.lastFrame = settings.value("Animation/last-frame", 0).toInt();
+
+    job.width = settings.value("Canvas/width").toInt();
+    job.height = settings.value("Canvas/height").toInt();
+
+    RayTracer::Config &rtConfig = job.config;
+    rtConfig.enableShadow        = settings.value("Feature/shadows").toBool();
+    rtConfig.enableReflection    = settings.value("Feature/reflect").toBool();
+    rtConfig.enableRefraction    = settings.value("Feature/refract").toBool();
+    rtConfig.enableTextureMap    = settings.value("Feature/texture").toBool();
+    rtConfig.enableTextureFilter = settings.value("Feature/texture-filter").toBool();
+    rtConfig.enableParallelism   = settings.value("Feature/parallel").toBool();
+    rtConfig.enableSuperSample   = settings.value("Feature/super-sample").toBool();
+    rtConfig.enableAcceleration  = settings.value("Feature/acceleration").toBool();
+    rtConfig.enableDepthOfField  = settings.value("Feature/depthoffield").toBool();
+    rtConfig.maxRecursiveDepth   = settings.value("Settings/maximum-recursive-depth").toInt();
+    rtConfig.onlyRenderNormals   = settings.value("Settings/only-render-normals").toBool();
+    rtConfig.enableMotionBlur  = settings.value("Feature/motion-blur").toBool();
+    rtConfig.enableLens = !job.lensPath.isEmpty();
+    rtConfig.lightFieldSamples = settings.value("Settings/light-field-samples", rtConfig.lightFieldSamples).toInt();
+    rtConfig.lightTreeSamples = std::max(settings.value("Settings/light-samples", rtConfig.lightTreeSamples).toInt(), 0);
+
+    job.incremental = settings.value("Feature/incremental").toBool();
+    job.visibilityCache = settings.value("Feature/visibility-cache").toBool();
+    job.stats = settings.value("Settings/stats").toString();
+
+    QString costMap = settings.value("Settings/cost-map").toString();
+    if (costMap == "tests") {
+        job.costMetric = RayTracer::CostMetric::IntersectionTests;
+    } else if (costMap == "rays") {
+        job.costMetric = RayTracer::CostMetric::Rays;
+    } else if (costMap == "time") {
+        job.costMetric = RayTracer::CostMetric::Nanoseconds;
+    } else if (!costMap.isEmpty()) {
+        std::cerr << "Error: unknown Settings/cost-map \"" << costMap.toStdString() << "\" in \""
+                  << iniPath.toStdString() << "\" (expected tests, rays or time)" << std::endl;
+        return false;
+    }
+    if (job.costMetric && *job.costMetric != RayTracer::CostMetric::Nanoseconds && !RenderStats::enabled()) {
+        std::cerr << "Warning: Settings/cost-map = " << costMap.toStdString() << " in \"" << iniPath.toStdString()
+                  << "\" counts with statistics, which are not compiled in; build with -DRT_ENABLE_STATS=ON" << std::endl;
+        job.costMetric.reset();
+    }
+    job.temporal = settings.value("Feature/temporal").toBool();
+    job.temporalHistory = std::max(settings.value("Settings/temporal-history", job.temporalHistory).toInt(), 1);
+
+    // accumulated frames need far fewer samples each, so temporal jobs default to a quarter of them
+    int divisor = job.temporal ? 4 : 1;
+    rtConfig.depthOfFieldSamples = settings.value("Settings/depth-of-field-samples", (rtConfig.depthOfFieldSamples + divisor - 1) / divisor).toInt();
+    rtConfig.motionBlurSamples = settings.value("Settings/motion-blur-samples", (rtConfig.motionBlurSamples + divisor - 1) / divisor).toInt();
+    rtConfig.areaLightSamples = settings.value("Settings/area-light-samples", (rtConfig.areaLightSamples + divisor - 1) / divisor).toInt();
+
+    job.lightField = settings.value("Feature/light-field").toBool();
+    job.lightFieldFrames = std::max(settings.value("LightField/frames", 1).toInt(), 1);
+    job.apertureStart = optionalFloat(settings, "LightField/aperture-start");
+    job.apertureEnd = optionalFloat(settings, "LightField/aperture-end");
+    job.focalLengthStart = optionalFloat(settings, "LightField/focal-length-start");
+    job.focalLengthEnd = optionalFloat(settings, "LightField/focal-length-end");
+
+    return true;
+}
+
+QStringList BatchRenderer::expandInputs(const QStringList &inputs) {
+    QStringList iniPaths;
+
+    for (const QString &input : inputs) {
+        QFileInfo info(input);
+
+        if (input.contains("*") || input.contains("?")) {
+            QDir dir(info.path());
+            QStringList matches = dir.entryList(QStringList{info.fileName()}, QDir::Files);
+
+            // numeric ordering keeps scene_2 before scene_10
+            QCollator collator;
+            collator.setNumericMode(true);
+            std::sort(matches.begin(), matches.end(), collator);
+
+            for (const QString &match : matches) {
+                iniPaths.append(dir.filePath(match));
+            }
+        }
+        else if (info.suffix() == "txt" || info.suffix() == "list") {
+            QFile manifest(input);
+            if (!manifest.open(QIODevice::ReadOnly | QIODevice::Text)) {
+                std::cerr << "Error: could not open manifest \"" << input.toStdString() << "\"" << std::endl;
+                continue;
+            }
+
+            // entries are relative to the manifest itself
+            QDir manifestDir = info.absoluteDir();
+            QTextStream stream(&manifest);
+            QStringList entries;
+            while (!stream.atEnd()) {
+                QString line = stream.readLine().trimmed();
+                if (line.isEmpty() || line.startsWith("#")) {
+                    continue;
+                }
+                entries.append(QFileInfo(line).isRelative() ? manifestDir.filePath(line) : line);
+            }
+            iniPaths.append(expandInputs(entries));
+        }
+        else {
+            iniPaths.append(input);
+        }
+    }
+
+    return iniPaths;
+}
+
+std::vector<RenderJob> BatchRenderer::expandAnimations(const std::vector<RenderJob> &jobs, int &failures) {
+    std::vector<RenderJob> expanded;
+    std::map<QString, std::shared_ptr<const Animation>> animations;
+
+    for (const RenderJob &job : jobs) {
+        if (job.animationPath.isEmpty()) {
+            expanded.push_back(job);
+            continue;
+        }
+
+        std::shared_ptr<const Animation> &animation = animations[job.animationPath];
+        if (!animation) {
+            auto parsed = std::make_shared<Animation>();
+            if (!SceneParser::parseAnimation(job.animationPath.toStdString(), *parsed)) {
+                std::cerr << "Error loading animation: \"" << job.animationPath.toStdString() << "\"" << std::endl;
+                animations.erase(job.animationPath);
+                failures++;
+                continue;
+            }
+            animation = parsed;
+        }
+
+        int firstFrame = job.firstFrame > 0 ? job.firstFrame : 1;
+        int lastFrame = job.lastFrame > 0 ? std::min(job.lastFrame, animation->frameCount()) : animation->frameCount();
+        if (lastFrame > firstFrame && !job.outputPath.contains("%1")) {
+            std::cerr << "Error: IO/output must contain \"%1\" to render several frames of \""
+                      << job.animationPath.toStdString() << "\"" << std::endl;
+            failures++;
+            continue;
+        }
+
+        for (int frame = firstFrame; frame <= lastFrame; frame++) {
+            RenderJob frameJob = job;
+            frameJob.animation = animation;
+            frameJob.frame = frame;
+            frameJob.outputPath = job.outputPath.contains("%1") ? job.outputPath.arg(frame) : job.outputPath;
+            expanded.push_back(frameJob);
+        }
+    }
+
+    return expanded;
+}
+
+void BatchRenderer::setTextureStreaming(std::size_t budgetBytes, const QString &cacheDir) {
+    m_textures.setStreaming(budgetBytes, cacheDir);
+}
+
+void BatchRenderer::setTextureAtlases(bool atlases) {
+    m_textures.setAtlases(atlases);
+}
+
+void BatchRenderer::setTextureCompression(float maxError) {
+    m_textures.setCompression(maxError);
+}
+
+// Helper function returning whether a job renders the frame after the previous job's and builds on it:
+// both re-trace only what changed, accumulate samples over frames or remember where shapes cast shadows
+// in the same way, and they are frames of the same animation or scene files in the same folder
+bool continuesSequence(const RenderJob &previous, const RenderJob &job) {
+    if (!(previous.incremental || previous.temporal || previous.visibilityCache) ||
+        previous.incremental != job.incremental || previous.temporal != job.temporal ||
+        previous.visibilityCache != job.visibilityCache) {
+        return false;
+    }
+    if (previous.animation || job.animation) {
+        return previous.animation == job.animation && previous.iniPath == job.iniPath;
+    }
+    return QFileInfo(previous.scenePath).path() == QFileInfo(job.scenePath).path();
+}
+
+// Helper function to split the jobs into sequences, the ranges [first, last) of jobs that one worker renders in order
+std::vector<std::pair<int, int>> splitSequences(const std::vector<RenderJob> &jobs) {
+    std::vector<std::pair<int, int>> sequences;
+    for (int i = 0; i < (int)jobs.size(); i++) {
+        if (i > 0 && continuesSequence(jobs[i - 1], jobs[i])) {
+            sequences.back().second = i + 1;
+        } else {
+            sequences.push_back({i, i + 1});
+        }
+    }
+    return sequences;
+}
+
+int BatchRenderer::run(const std::vector<RenderJob> &inputJobs) {
+    int animationFailures = 0;
+    std::vector<RenderJob> jobs = expandAnimations(inputJobs, animationFailures);
+
+    // a frame that builds on the one before it must come right after it on the same worker, whatever the
+    // number of threads, so each sequence is rendered in order by one worker starting from a clean slate
+    std::vector<std::pair<int, int>> sequences = splitSequences(jobs);
+    std::atomic<int> nextSequence = 0;
+    std::atomic<int> failures = animationFailures;
+
+    // each worker keeps its own geometry between frames, which only saves work
+    auto worker = [&]() {
+        SceneGeometry geometry(&m_textures);
+        int s;
+        while ((s = nextSequence++) < (int)sequences.size()) {
+            // a temporal frame's output must not depend on the scheduling: its history is only ever the
+            // frames before it in its own sequence
+            IncrementalRenderer incremental;
+            TemporalAccumulator temporal;
+            VisibilityCache visibility;
+            for (int i = sequences[s].first; i < sequences[s].second; i++) {
+                // a job's statistics are everything its worker gathered while rendering it
+                RenderStats::take();
+                TraceLog::Span span("job", "batch", TraceLog::isEnabled() ? "{\"output\": " + TraceLog::quote(jobs[i].outputPath.toStdString()) + "}" : "");
+                if (!renderJob(jobs[i], geometry, incremental, temporal, visibility)) {
+                    failures++;
+                }
+                if (!jobs[i].stats.isEmpty()) {
+                    reportStats(jobs[i], RenderStats::take());
+                }
+            }
+        }
+    };
+
+    int workers = std::min(m_threads, (int)sequences.size());
+    if (workers <= 1) {
+        worker();
+        return failures;
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(workers);
+    for (int w = 0; w < workers; w++) {
+        pool.start(worker);
+    }
+    pool.waitForDone();
+
+    return failures;
+}
+
+bool BatchRenderer::renderJob(const RenderJob &job, SceneGeometry &geometry, IncrementalRenderer &incremental,
+                              TemporalAccumulator &temporal, VisibilityCache &visibility) {
+    RenderData metaData;
+
+    {
+        RT_STAT_TIMER(Parse);
+        if (job.animation) {
+            // the base scene was parsed once for the whole animation
+            job.animation->getFrame(job.frame, metaData);
+        }
+        else {
+            bool sceneSuccess = SceneParser::parseScene(job.scenePath.toStdString(), metaData);
+
+            if (!sceneSuccess) {
+                std::cerr << "Error loading scene: \"" << job.scenePath.toStdString() << "\"" << std::endl;
+                return false;
+            }
+        }
+
+        if (!job.lensPath.isEmpty()) {
+            bool lensSuccess = SceneParser::parseLens(job.lensPath.toStdString(), metaData);
+
+            if (!lensSuccess) {
+                std::cerr << "Error loading lens: \"" << job.lensPath.toStdString() << "\"" << std::endl;
+                return false;
+            }
+        }
+    }
+
+    // Raytracing-relevant code starts here
+
+    // Extracting data pointer from Qt's image API
+    QImage image = QImage(job.width, job.height, QImage::Format_RGBX8888);
+    image.fill(Qt::black);
+    RGBA *data = reinterpret_cast<RGBA *>(image.bits());
+
+    RayTracer raytracer{ job.config };
+
+    // tiles an incremental or temporal job copies from its previous frame cost nothing
+    std::vector<float> costs;
+    if (job.costMetric) {
+        costs.assign(job.width * job.height, 0.0f);
+        raytracer.setCostMap(costs.data(), *job.costMetric);
+    }
+
+    RayTraceScene rtScene{ job.width, job.height, metaData };
+
+    // only the shapes that differ from this worker's previous frame are rebuilt
+    std::vector<int> rebuilt = geometry.update(rtScene.getShapes());
+
+    // the shapes that were not rebuilt are static, and where they can cast shadows is remembered across frames
+    if (job.visibilityCache) {
+        visibility.update(rtScene, geometry, rebuilt);
+        raytracer.setVisibilityCache(&visibility);
+    }
+
+    if (job.lightField) {
+        // Capture once, then synthesize every requested focus/aperture setting from the samples.
+        // A "%1" in the output path is replaced with the frame number.
+        LightField lightField;
+        raytracer.captureLightField(lightField, rtScene, geometry);
+
+        float apertureStart = job.apertureStart.value_or(metaData.cameraData.aperture);
+        float apertureEnd = job.apertureEnd.value_or(apertureStart);
+        float focalStart = job.focalLengthStart.value_or(metaData.cameraData.focalLength);
+        float focalEnd = job.focalLengthEnd.value_or(focalStart);
+
+        bool success = true;
+        if (job.costMetric) {
+            QString capturePath = job.outputPath.contains("%1") ? job.outputPath.arg(1) : job.outputPath;
+            success = saveCostMap(costs, job.width, job.height, *job.costMetric, capturePath);
+        }
+        for (int i = 0; i < job.lightFieldFrames; i++) {
+            float t = job.lightFieldFrames > 1 ? static_cast<float>(i) / (job.lightFieldFrames - 1) : 0.0f;
+            lightField.synthesize(data, glm::mix(apertureStart, apertureEnd, t), glm::mix(focalStart, focalEnd, t));
+
+            QString framePath = job.outputPath.contains("%1") ? job.outputPath.arg(i + 1) : job.outputPath;
+            success = saveImage(image, framePath) && success;
+        }
+        return success;
+    }
+
+    // accumulation changes every pixel, so it takes the place of incremental rendering
+    if (job.temporal) {
+        temporal.setMaxHistory(job.temporalHistory);
+        int reused = temporal.render(raytracer, data, rtScene, geometry);
+        std::cout << "Reused the history of " << reused << " of " << job.width * job.height << " pixels for \""
+                  << job.outputPath.toStdString() << "\"" << std::endl;
+        return saveImage(image, job.outputPath) &&
+               (!job.costMetric || saveCostMap(costs, job.width, job.height, *job.costMetric, job.outputPath));
+    }
+
+    if (job.incremental) {
+        int traced = incremental.render(raytracer, data, rtScene, geometry);
+        std::cout << "Traced " << traced << " of " << incremental.tileCount() << " tiles for \""
+                  << job.outputPath.toStdString() << "\"" << std::endl;
+        return saveImage(image, job.outputPath) &&
+               (!job.costMetric || saveCostMap(costs, job.width, job.height, *job.costMetric, job.outputPath));
+    }
+
+    // Note that we're passing `data` as a pointer (to its first element)
+    // Recall from Lab 1 that you can access its elements like this: `data[i]`
+    raytracer.render(data, rtScene, geometry);
+
+    // Saving the image
+    return saveImage(image, job.outputPath) &&
+           (!job.costMetric || saveCostMap(costs, job.width, job.height, *job.costMetric, job.outputPath));
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "incrementalrenderer.h"
+#include "temporalaccumulator.h"
+#include "visibilitycache.h"
+#include "raytracer.h"
+#include "scenegeometry.h"
+#include "utils/animation.h"
+#include "utils/texturecache.h"
+
+// Everything needed to render one .ini file
+struct RenderJob {
+    QString iniPath;
+    QString scenePath;
+    QString lensPath;
+    QString outputPath;
+
+    // Animated scenes (see Animation) replace the scene file and render one image per frame,
+    // with "%1" in the output path replaced by the frame number
+    QString animationPath;
+    int firstFrame = 0; // 0 renders from the first frame
+    int lastFrame = 0;  // 0 renders to the last frame
+
+    // Set on the per-frame jobs an animation job is expanded into
+    std::shared_ptr<const Animation> animation;
+    int frame = 0;
+
+    int width = 0;
+    int height = 0;
+
+    RayTracer::Config config;
+
+    // Re-trace only the parts of the image that changed since the previous frame (see IncrementalRenderer).
+    // Consecutive incremental jobs from one animation, or with their scene files in one folder, are a sequence
+    // that a single worker renders in order.
+    bool incremental = false;
+
+    // Blend each frame with the reprojected previous frames of its sequence (see TemporalAccumulator);
+    // temporal jobs form sequences the same way incremental jobs do
+    bool temporal = false;
+    int temporalHistory = 8;
+
+    // Test shadow rays only against the shapes that can reach them, remembered across the frames of a sequence
+    // (see VisibilityCache); visibility-cache jobs form sequences the same way incremental jobs do
+    bool visibilityCache = false;
+
+    // Where to report the job's render statistics (see RenderStats): "stderr", "json" for <output>.stats.json,
+    // or empty for nowhere
+    QString stats;
+
+    // Also write a heatmap of each pixel's cost next to the output (see RayTracer::setCostMap)
+    std::optional<RayTracer::CostMetric> costMetric;
+
+    // Light field capture (see LightField); unset sweep values default to the scene's camera
+    bool lightField = false;
+    int lightFieldFrames = 1;
+    std::optional<float> apertureStart, apertureEnd;
+    std::optional<float> focalLengthStart, focalLengthEnd;
+};
+
+// A class rendering a list of .ini files in a single process.
+// Decoded textures are shared by all frames, each worker keeps the shapes that did not
+// change from its previous frame, and frames are rendered in parallel on spare cores
+// (the frames of a sequence one after another on the same worker).
+
+class BatchRenderer
+{
+public:
+    // @param threads The maximum number of frames to render at once.
+    BatchRenderer(int threads);
+
+    // Reads the .ini file at iniPath into job.
+    // @return A boolean value indicating whether the file could be read.
+    static bool loadJob(const QString &iniPath, RenderJob &job);
+
+    // Expands the command-line inputs into a list of .ini files. An input can be an .ini file,
+    // a glob such as inifiles/falling_spheres/*.ini, or a manifest (.txt or .list) that lists
+    // one .ini file or glob per line. Globs are sorted so that numbered frames stay in order.
+    static QStringList expandInputs(const QStringList &inputs);
+
+    // Renders every job.
+    // @return The number of jobs that failed.
+    int run(const std::vector<RenderJob> &jobs);
+
+    // Streams the batch's textures through at most budgetBytes of memory (see TextureCache::setStreaming)
+    void setTextureStreaming(std::size_t budgetBytes, const QString &cacheDir);
+
+    // Packs the batch's small textures into atlases (see TextureCache::setAtlases)
+    void setTextureAtlases(bool atlases);
+
+    // Keeps the batch's textures compressed in memory, within maxError (see TextureCache::setCompression)
+    void setTextureCompression(float maxError);
+
+private:
+    // Replaces each animation job with one job per frame, parsing every animation once
+    std::vector<RenderJob> expandAnimations(const std::vector<RenderJob> &jobs, int &failures);
+
+    bool renderJob(const RenderJob &job, SceneGeometry &geometry, IncrementalRenderer &incremental,
+                   TemporalAccumulator &temporal, VisibilityCache &visibility);
+
+    int m_threads;
+    TextureCache m_textures;
+};
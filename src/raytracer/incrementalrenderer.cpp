@@ -0,0 +1,331 @@
+#include "incrementalrenderer.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+
+// Helper function to check whether two frames are rendered with the same settings
+bool sameConfig(const RayTracer::Config &a, const RayTracer::Config &b) {
+    return a.enableShadow == b.enableShadow && a.enableReflection == b.enableReflection &&
+           a.enableRefraction == b.enableRefraction && a.enableTextureMap == b.enableTextureMap &&
+           a.enableTextureFilter == b.enableTextureFilter && a.enableParallelism == b.enableParallelism &&
+           a.enableSuperSample == b.enableSuperSample && a.enableAcceleration == b.enableAcceleration &&
+           a.enableDepthOfField == b.enableDepthOfField && a.enableMotionBlur == b.enableMotionBlur &&
+           a.enableLens == b.enableLens && a.maxRecursiveDepth == b.maxRecursiveDepth &&
+           a.onlyRenderNormals == b.onlyRenderNormals && a.samples_per_pixel == b.samples_per_pixel &&
+           a.lightFieldSamples == b.lightFieldSamples && a.depthOfFieldSamples == b.depthOfFieldSamples &&
+           a.motionBlurSamples == b.motionBlurSamples && a.areaLightSamples == b.areaLightSamples &&
+           a.lightTreeSamples == b.lightTreeSamples;
+}
+
+// Helper function to compare two lights
+bool sameLight(const SceneLightData &a, const SceneLightData &b) {
+    return a.type == b.type && a.color == b.color && a.function == b.function &&
+           a.pos == b.pos && a.dir == b.dir && a.penumbra == b.penumbra && a.angle == b.angle &&
+           a.width == b.width && a.height == b.height && a.samples == b.samples;
+}
+
+// Helper function returning the eight corners of a box
+std::array<glm::vec3, 8> boxCorners(const BoundingBox &box) {
+    std::array<glm::vec3, 8> corners;
+    for (int i = 0; i < 8; i++) {
+        corners[i] = glm::vec3(i & 1 ? box.max.x : box.min.x,
+                               i & 2 ? box.max.y : box.min.y,
+                               i & 4 ? box.max.z : box.min.z);
+    }
+    return corners;
+}
+
+// Helper function returning the world-space bounds of a shape over the whole shutter interval.
+// All corners of the unit object box are transformed, so rotated shapes are bounded too.
+BoundingBox sweptBounds(const RenderShapeData &shape, float globalVel) {
+    glm::vec3 velocity = shape.primitive.velocity;
+
+    // cubes, cones and cylinders move by time * velocity in object space
+    BoundingBox objectBox(glm::min(glm::vec3(-0.5f), glm::vec3(-0.5f) + velocity),
+                          glm::max(glm::vec3(0.5f), glm::vec3(0.5f) + velocity));
+
+    glm::vec3 worldMin(std::numeric_limits<float>::max());
+    glm::vec3 worldMax(-std::numeric_limits<float>::max());
+    for (const glm::vec3 &corner : boxCorners(objectBox)) {
+        glm::vec3 world = glm::vec3(shape.ctm * glm::vec4(corner, 1.0f));
+        worldMin = glm::min(worldMin, world);
+        worldMax = glm::max(worldMax, world);
+    }
+
+    // spheres move by time * velocity.y * globalVel down the world y axis
+    glm::vec3 sphereOffset(0.0f, -velocity.y * globalVel, 0.0f);
+    return BoundingBox(glm::min(worldMin, worldMin + sphereOffset), glm::max(worldMax, worldMax + sphereOffset));
+}
+
+// Helper function to check whether a material shows other shapes
+bool showsOtherShapes(const SceneMaterial &material) {
+    return glm::any(glm::greaterThan(glm::vec3(material.cReflective), glm::vec3(0.0f))) ||
+           glm::any(glm::greaterThan(glm::vec3(material.cTransparent), glm::vec3(0.0f)));
+}
+
+IncrementalRenderer::IncrementalRenderer(int tileSize)
+    : m_tileSize(std::max(tileSize, 1))
+{}
+
+int IncrementalRenderer::tileCount() const {
+    return m_tilesX * m_tilesY;
+}
+
+bool IncrementalRenderer::needsFullFrame(const RayTracer::Config &config, const RayTraceScene &scene) const {
+    const Camera &camera = scene.getCamera();
+    const SceneGlobalData &global = scene.getGlobalData();
+    const std::vector<SceneLightData> &lights = scene.getLights();
+
+    // rays bent by a lens do not follow the pinhole projection the footprints are computed with
+    if (!m_valid || config.enableLens || !sameConfig(config, m_config)) {
+        return true;
+    }
+    if (scene.width() != m_width || scene.height() != m_height) {
+        return true;
+    }
+    if (camera.getViewMatrix() != m_viewMatrix || camera.getHeightAngle() != m_heightAngle ||
+        camera.getAperture() != m_aperture || camera.getFocalLength() != m_focalLength) {
+        return true;
+    }
+    if (global.ka != m_globalData.ka || global.kd != m_globalData.kd ||
+        global.ks != m_globalData.ks || global.kt != m_globalData.kt) {
+        return true;
+    }
+    if (lights.size() != m_lights.size() || scene.getShapes().size() != m_shapes.size()) {
+        return true;
+    }
+    for (int i = 0; i < (int)lights.size(); i++) {
+        if (!sameLight(lights[i], m_lights[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void IncrementalRenderer::markAll() {
+    std::fill(m_dirty.begin(), m_dirty.end(), true);
+}
+
+void IncrementalRenderer::markHull(const std::vector<glm::vec3> &points) {
+    // points just in front of the camera; the hull is clipped against this plane
+    const float nearPlane = 1e-3f;
+
+    glm::mat4 view = m_camera->getViewMatrix();
+    std::vector<glm::vec3> cameraPoints;
+    for (const glm::vec3 &point : points) {
+        cameraPoints.push_back(glm::vec3(view * glm::vec4(point, 1.0f)));
+    }
+
+    // the part of the hull in front of the camera is the hull of the points in front of it and of
+    // the points where the segments between them cross the near plane
+    std::vector<glm::vec3> visible;
+    for (int i = 0; i < (int)cameraPoints.size(); i++) {
+        const glm::vec3 &a = cameraPoints[i];
+        if (a.z < -nearPlane) {
+            visible.push_back(a);
+        }
+        for (int j = i + 1; j < (int)cameraPoints.size(); j++) {
+            const glm::vec3 &b = cameraPoints[j];
+            if ((a.z < -nearPlane) != (b.z < -nearPlane)) {
+                float t = (-nearPlane - a.z) / (b.z - a.z);
+                visible.push_back(glm::vec3(glm::mix(glm::vec2(a), glm::vec2(b), t), -nearPlane));
+            }
+        }
+    }
+    if (visible.empty()) {
+        return;
+    }
+
+    // the view plane extents used by RayTracer::renderRegion
+    float tanY = std::tan(m_camera->getHeightAngle() / 2.0f);
+    float tanX = m_depthOfField ? m_camera->getAspectRatio() * tanY : std::tan(m_camera->getWidthAngle() / 2.0f);
+
+    float minX = std::numeric_limits<float>::max(), maxX = -minX;
+    float minY = minX, maxY = -minX;
+    float minDepth = minX, maxDistance = 0.0f;
+    for (const glm::vec3 &point : visible) {
+        float x = point.x / -point.z / (2.0f * tanX);
+        float y = point.y / -point.z / (2.0f * tanY);
+        minX = std::min(minX, x);
+        maxX = std::max(maxX, x);
+        minY = std::min(minY, y);
+        maxY = std::max(maxY, y);
+        minDepth = std::min(minDepth, -point.z);
+        maxDistance = std::max(maxDistance, glm::length(point));
+    }
+
+    // one pixel for rounding and the anti-aliasing jitter, plus the largest circle of confusion
+    float margin = 1.0f;
+    if (m_depthOfField) {
+        float inverseFocal = 1.0f / m_camera->getFocalLength();
+        float defocus = std::max(std::abs(1.0f / minDepth - inverseFocal), std::abs(1.0f / maxDistance - inverseFocal));
+        margin += m_camera->getAperture() / 2.0f * defocus * m_height / (2.0f * tanY);
+    }
+
+    // columns grow with x, rows grow with -y (see RayTraceScene::getPoint)
+    float left = (minX + 0.5f) * m_width - 0.5f - margin;
+    float right = (maxX + 0.5f) * m_width - 0.5f + margin;
+    float top = m_height - 0.5f - (maxY + 0.5f) * m_height - margin;
+    float bottom = m_height - 0.5f - (minY + 0.5f) * m_height + margin;
+    if (right < 0.0f || bottom < 0.0f || left > m_width - 1 || top > m_height - 1) {
+        return;
+    }
+
+    int tileLeft = static_cast<int>(std::max(left, 0.0f)) / m_tileSize;
+    int tileRight = static_cast<int>(std::min(right, m_width - 1.0f)) / m_tileSize;
+    int tileTop = static_cast<int>(std::max(top, 0.0f)) / m_tileSize;
+    int tileBottom = static_cast<int>(std::min(bottom, m_height - 1.0f)) / m_tileSize;
+
+    for (int ty = tileTop; ty <= tileBottom; ty++) {
+        for (int tx = tileLeft; tx <= tileRight; tx++) {
+            m_dirty[ty * m_tilesX + tx] = true;
+        }
+    }
+}
+
+void IncrementalRenderer::markShadow(const BoundingBox &box, const SceneLightData &light, float sceneSize) {
+    std::array<glm::vec3, 8> corners = boxCorners(box);
+    std::vector<glm::vec3> points(corners.begin(), corners.end());
+
+    // shadows can only fall on shapes, so the shadow volume is cut off once it has crossed the whole scene
+    if (light.type == LightType::LIGHT_DIRECTIONAL) {
+        glm::vec3 direction = glm::normalize(glm::vec3(light.dir));
+        for (const glm::vec3 &corner : corners) {
+            points.push_back(corner + sceneSize * direction);
+        }
+        markHull(points);
+        return;
+    }
+
+    // an area light is bounded by a cube around its center; the shadows cast from any point inside
+    // the cube lie in the hull of the shadows cast from its corners
+    std::vector<glm::vec3> lightPoints = {glm::vec3(light.pos)};
+    if (light.type == LightType::LIGHT_AREA) {
+        float halfSize = 0.5f * std::max(light.width, light.height);
+        lightPoints.clear();
+        for (const glm::vec3 &corner : boxCorners(BoundingBox(glm::vec3(light.pos) - halfSize, glm::vec3(light.pos) + halfSize))) {
+            lightPoints.push_back(corner);
+        }
+    }
+
+    for (const glm::vec3 &lightPoint : lightPoints) {
+        if (glm::all(glm::greaterThanEqual(lightPoint, box.min)) && glm::all(glm::lessThanEqual(lightPoint, box.max))) {
+            // a light inside the box can shadow anything
+            markAll();
+            return;
+        }
+
+        float closest = std::numeric_limits<float>::max();
+        for (const glm::vec3 &corner : corners) {
+            closest = std::min(closest, glm::length(corner - lightPoint));
+        }
+
+        // scaling the box away from the light by this much moves every point at least sceneSize
+        float scale = 1.0f + sceneSize / std::max(closest, 1e-4f);
+        std::vector<glm::vec3> volume = points;
+        for (const glm::vec3 &corner : corners) {
+            volume.push_back(lightPoint + scale * (corner - lightPoint));
+        }
+        markHull(volume);
+    }
+}
+
+int IncrementalRenderer::render(RayTracer &raytracer, RGBA *imageData, const RayTraceScene &scene, const SceneGeometry &geometry) {
+    const RayTracer::Config &config = raytracer.getConfig();
+    const std::vector<RenderShapeData> &shapes = scene.getShapes();
+    const SceneGlobalData &global = scene.getGlobalData();
+
+    m_camera = &scene.getCamera();
+    m_depthOfField = config.enableDepthOfField;
+
+    bool fullFrame = needsFullFrame(config, scene);
+
+    m_width = scene.width();
+    m_height = scene.height();
+    m_tilesX = (m_width + m_tileSize - 1) / m_tileSize;
+    m_tilesY = (m_height + m_tileSize - 1) / m_tileSize;
+
+    if (fullFrame) {
+        raytracer.render(imageData, scene, geometry);
+        remember(config, scene, imageData);
+        return tileCount();
+    }
+
+    m_dirty.assign(tileCount(), false);
+
+    // shapes that changed, bounded both where they were and where they are now
+    std::vector<BoundingBox> changed;
+    for (int i = 0; i < (int)shapes.size(); i++) {
+        bool moving = shapes[i].primitive.velocity != glm::vec3(0.0f);
+        if (SceneGeometry::sameShape(shapes[i], m_shapes[i]) && (!moving || global.globalVel == m_globalData.globalVel)) {
+            continue;
+        }
+        changed.push_back(sweptBounds(m_shapes[i], m_globalData.globalVel));
+        changed.push_back(sweptBounds(shapes[i], global.globalVel));
+    }
+
+    if (!changed.empty()) {
+        // the extent of everything a shadow could fall on
+        glm::vec3 sceneMin(std::numeric_limits<float>::max());
+        glm::vec3 sceneMax(-std::numeric_limits<float>::max());
+        for (int i = 0; i < (int)shapes.size(); i++) {
+            for (const BoundingBox &box : {sweptBounds(shapes[i], global.globalVel), sweptBounds(m_shapes[i], m_globalData.globalVel)}) {
+                sceneMin = glm::min(sceneMin, box.min);
+                sceneMax = glm::max(sceneMax, box.max);
+            }
+        }
+        float sceneSize = glm::length(sceneMax - sceneMin);
+
+        for (const BoundingBox &box : changed) {
+            std::array<glm::vec3, 8> corners = boxCorners(box);
+            markHull(std::vector<glm::vec3>(corners.begin(), corners.end()));
+
+            for (const SceneLightData &light : scene.getLights()) {
+                markShadow(box, light, sceneSize);
+            }
+        }
+
+        // reflections and refractions can show a change anywhere in the scene
+        for (const RenderShapeData &shape : shapes) {
+            if (showsOtherShapes(shape.primitive.material)) {
+                std::array<glm::vec3, 8> corners = boxCorners(sweptBounds(shape, global.globalVel));
+                markHull(std::vector<glm::vec3>(corners.begin(), corners.end()));
+            }
+        }
+    }
+
+    std::memcpy(imageData, m_image.data(), m_image.size() * sizeof(RGBA));
+
+    int traced = 0;
+    for (int ty = 0; ty < m_tilesY; ty++) {
+        for (int tx = 0; tx < m_tilesX; tx++) {
+            if (!m_dirty[ty * m_tilesX + tx]) {
+                continue;
+            }
+            raytracer.renderRegion(imageData, scene, geometry,
+                                   tx * m_tileSize, ty * m_tileSize,
+                                   std::min((tx + 1) * m_tileSize, m_width), std::min((ty + 1) * m_tileSize, m_height));
+            traced++;
+        }
+    }
+
+    remember(config, scene, imageData);
+    return traced;
+}
+
+void IncrementalRenderer::remember(const RayTracer::Config &config, const RayTraceScene &scene, const RGBA *imageData) {
+    const Camera &camera = scene.getCamera();
+
+    m_valid = true;
+    m_config = config;
+    m_globalData = scene.getGlobalData();
+    m_viewMatrix = camera.getViewMatrix();
+    m_heightAngle = camera.getHeightAngle();
+    m_aperture = camera.getAperture();
+    m_focalLength = camera.getFocalLength();
+    m_lights = scene.getLights();
+    m_shapes = scene.getShapes();
+    m_image.assign(imageData, imageData + m_width * m_height);
+}
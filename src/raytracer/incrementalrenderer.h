@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+#include "raytracer.h"
+#include "raytracescene.h"
+#include "scenegeometry.h"
+#include "utils/boundingbox.h"
+
+// The world-space bounds of a shape over the whole shutter interval
+BoundingBox sweptBounds(const RenderShapeData &shape, float globalVel);
+
+// Whether two lights light the scene the same way
+bool sameLight(const SceneLightData &a, const SceneLightData &b);
+
+// A class rendering the frames of a sequence incrementally.
+// The image is split into tiles, and only the tiles a change since the previous frame can reach are
+// re-traced: the screen footprint of every changed shape (before and after the change), of the shadows
+// it can cast, and of every reflective or transparent shape that could show it. The footprints are
+// computed from bounding boxes, so they can be too large but never too small. All other tiles are
+// copied from the previous frame. Changes to the camera, lights, global coefficients or settings
+// re-trace the whole frame.
+
+class IncrementalRenderer
+{
+public:
+    IncrementalRenderer(int tileSize = 16);
+
+    // Renders the scene into imageData, reusing the previous frame wherever it cannot have changed.
+    // @param geometry The shapes of the scene, already updated for this frame.
+    // @return The number of tiles that were traced.
+    int render(RayTracer &raytracer, RGBA *imageData, const RayTraceScene &scene, const SceneGeometry &geometry);
+
+    // The number of tiles each frame is split into.
+    int tileCount() const;
+
+private:
+    // Whether nothing can be reused from the previous frame
+    bool needsFullFrame(const RayTracer::Config &config, const RayTraceScene &scene) const;
+
+    // Marks the tiles covered by the convex hull of points (in world space)
+    void markHull(const std::vector<glm::vec3> &points);
+
+    // Marks the tiles covered by box and by the shadows it can cast from light
+    void markShadow(const BoundingBox &box, const SceneLightData &light, float sceneSize);
+
+    void markAll();
+
+    void remember(const RayTracer::Config &config, const RayTraceScene &scene, const RGBA *imageData);
+
+    int m_tileSize;
+    int m_tilesX = 0;
+    int m_tilesY = 0;
+    std::vector<bool> m_dirty;
+
+    // the camera and settings of the frame being rendered, used by markHull
+    const Camera *m_camera = nullptr;
+    bool m_depthOfField = false;
+
+    // the previous frame
+    bool m_valid = false;
+    int m_width = 0;
+    int m_height = 0;
+    RayTracer::Config m_config;
+    SceneGlobalData m_globalData;
+    glm::mat4 m_viewMatrix;
+    float m_heightAngle = 0.0f;
+    float m_aperture = 0.0f;
+    float m_focalLength = 0.0f;
+    std::vector<SceneLightData> m_lights;
+    std::vector<RenderShapeData> m_shapes;
+    std::vector<RGBA> m_image;
+};
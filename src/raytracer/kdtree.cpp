@@ -1,4 +1,5 @@
 #include "kdtree.h"
+#include "utils/renderstats.h"
 #include <iostream>
 
 KdTree::KdNode* KdTree::build(std::vector<Shape*>& shapes, const BoundingBox& parentBox, int depth) {
@@ -69,6 +70,7 @@ KdTree::KdNode* KdTree::build(std::vector<Shape*>& shapes, const BoundingBox& pa
 }
 
 std::vector<Shape*> KdTree::query(const glm::vec3& origin, const glm::vec3& direction, KdTree::KdNode* node) {
+    RT_STAT_INC(NodeVisits);
 
 
     return node->shapes;
@@ -97,3 +99,11 @@ std::vector<Shape*> KdTree::query(const glm::vec3& origin, const glm::vec3& dire
 
     // return result;
 }
+
+void KdTree::release(KdTree::KdNode* node) {
+    if (!node) return;
+
+    release(node->left);
+    release(node->right);
+    delete node;
+}
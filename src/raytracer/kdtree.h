@@ -25,6 +25,8 @@ public:
     KdNode* build(std::vector<Shape*>& shapes, const BoundingBox& parentBox, int depth = 0);
     // KdNode* insert(KdNode* node, Shape* shape, int depth = 0);
     std::vector<Shape*> query(const glm::vec3& origin, const glm::vec3& direction, KdNode* node);
+    // Frees node and all of its children. The shapes are not owned by the tree and are left alone.
+    void release(KdNode* node);
 
 };
 
@@ -0,0 +1,123 @@
+#include "lightfield.h"
+#include <glm/gtc/packing.hpp>
+#include <cmath>
+#include <limits>
+
+void LightField::reset(const Camera &camera, int width, int height, int samplesPerPixel) {
+    m_width = width;
+    m_height = height;
+    m_samplesPerPixel = samplesPerPixel;
+
+    m_aperture = camera.getAperture();
+    m_focalLength = camera.getFocalLength();
+
+    // same camera frame as the depth of field path in RayTracer::render
+    m_position = camera.getPosition();
+    m_look = glm::normalize(camera.getLook());
+    glm::vec3 upInitial = glm::normalize(camera.getUp());
+    m_right = glm::normalize(glm::cross(m_look, upInitial));
+    m_up = glm::normalize(glm::cross(m_right, m_look));
+
+    m_viewplaneHeight = 2.0f * tan(camera.getHeightAngle() / 2.0f);
+    m_viewplaneWidth = camera.getAspectRatio() * m_viewplaneHeight;
+
+    m_samples.assign(static_cast<size_t>(width) * height * samplesPerPixel, Sample{});
+}
+
+glm::vec3 LightField::pixelDirection(float x, float y) const {
+    float multiplierX = 2.0f * (x + 0.5f) / static_cast<float>(m_width) - 1.0f;
+    float multiplierY = 1.0f - 2.0f * (y + 0.5f) / static_cast<float>(m_height);
+
+    glm::vec3 horizontal = (m_viewplaneWidth / 2.0f) * m_right;
+    glm::vec3 vertical = (m_viewplaneHeight / 2.0f) * m_up;
+    return glm::normalize(m_look + multiplierX * horizontal + multiplierY * vertical);
+}
+
+void LightField::primaryRay(int r, int c, glm::vec2 jitter, glm::vec2 lensPoint, glm::vec3 &origin, glm::vec3 &direction) const {
+    glm::vec3 rayDirection = pixelDirection(c + jitter.x, r + jitter.y);
+    glm::vec3 focalPoint = m_position + m_focalLength * rayDirection;
+
+    glm::vec3 offset = (m_aperture / 2.0f) * (lensPoint.x * m_right + lensPoint.y * m_up);
+    origin = m_position + offset;
+    direction = glm::normalize(focalPoint - origin);
+}
+
+void LightField::store(int r, int c, int s, glm::vec4 color, float depth, glm::vec2 jitter, glm::vec2 lensPoint) {
+    Sample &sample = m_samples[(static_cast<size_t>(r) * m_width + c) * m_samplesPerPixel + s];
+    sample.color = glm::packHalf(glm::vec3(color));
+    sample.depth = depth;
+    sample.u = static_cast<std::int16_t>(lensPoint.x * LENS_SCALE);
+    sample.v = static_cast<std::int16_t>(lensPoint.y * LENS_SCALE);
+    sample.jitterX = static_cast<std::int8_t>(jitter.x * JITTER_SCALE);
+    sample.jitterY = static_cast<std::int8_t>(jitter.y * JITTER_SCALE);
+}
+
+void LightField::synthesize(RGBA *imageData, float aperture, float focalLength) const {
+    std::vector<glm::vec4> accumulated(static_cast<size_t>(m_width) * m_height, glm::vec4(0.0f));
+
+    for (int r = 0; r < m_height; r++) {
+        for (int c = 0; c < m_width; c++) {
+            for (int s = 0; s < m_samplesPerPixel; s++) {
+                const Sample &sample = m_samples[(static_cast<size_t>(r) * m_width + c) * m_samplesPerPixel + s];
+                glm::vec2 jitter(sample.jitterX / JITTER_SCALE, sample.jitterY / JITTER_SCALE);
+                glm::vec2 lensPoint(sample.u / LENS_SCALE, sample.v / LENS_SCALE);
+
+                // recover the captured ray and its hit point
+                glm::vec3 origin, direction;
+                primaryRay(r, c, jitter, lensPoint, origin, direction);
+
+                // the same hit seen from the same relative position on the new lens
+                glm::vec3 newOrigin = m_position + (aperture / 2.0f) * (lensPoint.x * m_right + lensPoint.y * m_up);
+                glm::vec3 newDirection = direction;
+                if (std::isfinite(sample.depth)) {
+                    newDirection = glm::normalize(origin + sample.depth * direction - newOrigin);
+                }
+
+                // find where the ray crosses the new focal surface and which pixel looks at that point
+                glm::vec3 w = newOrigin - m_position;
+                float wd = glm::dot(w, newDirection);
+                float discriminant = wd * wd - glm::dot(w, w) + focalLength * focalLength;
+                if (discriminant < 0.0f) {
+                    continue;
+                }
+                glm::vec3 focalPoint = newOrigin + (-wd + std::sqrt(discriminant)) * newDirection;
+                glm::vec3 pixelDir = focalPoint - m_position;
+
+                float z = glm::dot(pixelDir, m_look);
+                if (z <= 0.0f) {
+                    continue;
+                }
+                float multiplierX = glm::dot(pixelDir, m_right) / z / (m_viewplaneWidth / 2.0f);
+                float multiplierY = glm::dot(pixelDir, m_up) / z / (m_viewplaneHeight / 2.0f);
+
+                int targetC = static_cast<int>(std::floor((multiplierX + 1.0f) / 2.0f * m_width));
+                int targetR = static_cast<int>(std::floor((1.0f - multiplierY) / 2.0f * m_height));
+                if (targetC < 0 || targetC >= m_width || targetR < 0 || targetR >= m_height) {
+                    continue;
+                }
+
+                accumulated[targetR * m_width + targetC] += glm::vec4(glm::unpackHalf(sample.color), 1.0f);
+            }
+        }
+    }
+
+    for (int r = 0; r < m_height; r++) {
+        for (int c = 0; c < m_width; c++) {
+            glm::vec4 sum = accumulated[r * m_width + c];
+
+            // pixels no sample landed in fall back to their own captured samples
+            if (sum.a == 0.0f) {
+                for (int s = 0; s < m_samplesPerPixel; s++) {
+                    const Sample &sample = m_samples[(static_cast<size_t>(r) * m_width + c) * m_samplesPerPixel + s];
+                    sum += glm::vec4(glm::unpackHalf(sample.color), 1.0f);
+                }
+            }
+
+            glm::vec3 color = glm::clamp(glm::vec3(sum) / glm::max(sum.a, 1.0f), 0.0f, 1.0f);
+            imageData[r * m_width + c] = RGBA{static_cast<std::uint8_t>(color.r * 255.0f),
+                                              static_cast<std::uint8_t>(color.g * 255.0f),
+                                              static_cast<std::uint8_t>(color.b * 255.0f),
+                                              255};
+        }
+    }
+}
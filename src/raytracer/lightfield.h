@@ -0,0 +1,73 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+#include <cstdint>
+#include <vector>
+#include "utils/rgba.h"
+#include "camera/camera.h"
+
+// A class representing a captured light field: every primary sample of a depth of field
+// render, stored with the lens position it was traced from and the depth of its hit.
+// Refocused or re-apertured images are synthesized from the stored samples without
+// tracing any new rays.
+
+class LightField
+{
+public:
+    struct Sample {
+        float depth;            // distance from the lens point to the primary hit, infinite on a miss
+        glm::u16vec3 color;     // radiance carried by the sample, unclamped, as half floats
+        std::int16_t u, v;      // lens position on the unit disk, scaled by LENS_SCALE
+        std::int8_t jitterX;    // sub-pixel offset of the sample, scaled by JITTER_SCALE
+        std::int8_t jitterY;
+    };
+
+    static constexpr float LENS_SCALE = 32767.0f;
+    static constexpr float JITTER_SCALE = 127.0f;
+
+    // Prepares storage for a capture of width * height pixels with samplesPerPixel samples each.
+    // The camera's aperture and focal length are the ones the samples are traced with.
+    void reset(const Camera &camera, int width, int height, int samplesPerPixel);
+
+    // Computes the primary ray for a sample of pixel (r, c).
+    // @param jitter     The sub-pixel offset of the sample, in [-0.5, 0.5].
+    // @param lensPoint  The sample's position on the unit disk.
+    void primaryRay(int r, int c, glm::vec2 jitter, glm::vec2 lensPoint, glm::vec3 &origin, glm::vec3 &direction) const;
+
+    // Stores sample s of pixel (r, c).
+    void store(int r, int c, int s, glm::vec4 color, float depth, glm::vec2 jitter, glm::vec2 lensPoint);
+
+    // Synthesizes an image focused at focalLength through a lens of the given aperture.
+    // Each sample keeps its hit point and is re-binned to the pixel its ray would reach
+    // through the new lens, so no rays are traced. Pixels average their samples' radiance
+    // before clamping it, as the depth of field render does.
+    // @param imageData The pointer to the width * height image to be filled.
+    void synthesize(RGBA *imageData, float aperture, float focalLength) const;
+
+    bool isEmpty() const { return m_samples.empty(); }
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    int samplesPerPixel() const { return m_samplesPerPixel; }
+
+private:
+    // Direction of the pinhole ray through a (possibly fractional) pixel position
+    glm::vec3 pixelDirection(float x, float y) const;
+
+    int m_width = 0;
+    int m_height = 0;
+    int m_samplesPerPixel = 0;
+
+    float m_aperture = 0.0f;
+    float m_focalLength = 0.0f;
+
+    // camera frame and viewplane extent at distance 1 used during capture
+    glm::vec3 m_position;
+    glm::vec3 m_look;
+    glm::vec3 m_right;
+    glm::vec3 m_up;
+    float m_viewplaneWidth = 0.0f;
+    float m_viewplaneHeight = 0.0f;
+
+    std::vector<Sample> m_samples;
+};
@@ -0,0 +1,188 @@
+#include "lighttree.h"
+
+#include <glm/gtx/rotate_vector.hpp>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Helper function returning the angle between two unit vectors
+float angleBetween(glm::vec3 a, glm::vec3 b) {
+    return std::acos(glm::clamp(glm::dot(a, b), -1.0f, 1.0f));
+}
+
+LightTree::LightTree(const std::vector<SceneLightData> &lights, const std::vector<float> &radii) {
+    std::vector<int> order;
+    for (int i = 0; i < (int)lights.size(); i++) {
+        if (lights[i].type == LightType::LIGHT_DIRECTIONAL) {
+            m_unbounded.push_back(i);
+        } else {
+            order.push_back(i);
+        }
+    }
+
+    if (!order.empty()) {
+        m_nodes.reserve(2 * order.size() - 1);
+        build(order, 0, static_cast<int>(order.size()), lights, radii);
+    }
+}
+
+int LightTree::size() const {
+    return static_cast<int>(m_nodes.size() + 1) / 2;
+}
+
+const std::vector<int>& LightTree::unboundedLights() const {
+    return m_unbounded;
+}
+
+int LightTree::build(std::vector<int> &order, int begin, int end, const std::vector<SceneLightData> &lights,
+                     const std::vector<float> &radii) {
+    int index = static_cast<int>(m_nodes.size());
+    m_nodes.emplace_back();
+
+    if (end - begin == 1) {
+        const SceneLightData &light = lights[order[begin]];
+        Node node;
+        glm::vec3 position(light.pos);
+        // an area light is bounded by the sphere around its rectangle
+        float radius = light.type == LightType::LIGHT_AREA ? 0.5f * std::sqrt(light.width * light.width + light.height * light.height) : 0.0f;
+        node.boundsMin = position - glm::vec3(radius);
+        node.boundsMax = position + glm::vec3(radius);
+
+        if (light.type == LightType::LIGHT_SPOT) {
+            node.axis = glm::normalize(glm::vec3(light.dir));
+            node.thetaO = 0.0f;
+            node.thetaE = light.angle;
+        } else {
+            // point and area lights shine every way
+            node.axis = glm::vec3(0, 0, 1);
+            node.thetaO = float(M_PI);
+            node.thetaE = float(M_PI) / 2.0f;
+        }
+        node.power = (light.color.r + light.color.g + light.color.b) / 3.0f;
+        node.function = light.function;
+        node.influence = radii[order[begin]];
+        node.light = order[begin];
+        m_nodes[index] = node;
+        return index;
+    }
+
+    // split at the median along the longest axis of the lights' positions
+    glm::vec3 low(std::numeric_limits<float>::max()), high(-std::numeric_limits<float>::max());
+    for (int i = begin; i < end; i++) {
+        low = glm::min(low, glm::vec3(lights[order[i]].pos));
+        high = glm::max(high, glm::vec3(lights[order[i]].pos));
+    }
+    glm::vec3 extent = high - low;
+    int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+    int middle = (begin + end) / 2;
+    std::nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end,
+                     [&](int a, int b) { return lights[a].pos[axis] < lights[b].pos[axis]; });
+
+    int left = build(order, begin, middle, lights, radii);
+    int right = build(order, middle, end, lights, radii);
+    const Node &a = m_nodes[left];
+    const Node &b = m_nodes[right];
+
+    Node node;
+    node.boundsMin = glm::min(a.boundsMin, b.boundsMin);
+    node.boundsMax = glm::max(a.boundsMax, b.boundsMax);
+    node.power = a.power + b.power;
+    node.function = glm::min(a.function, b.function);
+    node.thetaE = std::max(a.thetaE, b.thetaE);
+    glm::vec3 center = (node.boundsMin + node.boundsMax) / 2.0f;
+    node.influence = std::max(a.influence + glm::length((a.boundsMin + a.boundsMax) / 2.0f - center),
+                              b.influence + glm::length((b.boundsMin + b.boundsMax) / 2.0f - center));
+    node.left = left;
+    node.right = right;
+
+    // the smallest cone holding both children's cones
+    const Node &wide = a.thetaO >= b.thetaO ? a : b;
+    const Node &narrow = a.thetaO >= b.thetaO ? b : a;
+    float thetaD = angleBetween(wide.axis, narrow.axis);
+    float thetaO = (wide.thetaO + thetaD + narrow.thetaO) / 2.0f;
+    glm::vec3 rotationAxis = glm::cross(wide.axis, narrow.axis);
+    if (std::min(thetaD + narrow.thetaO, float(M_PI)) <= wide.thetaO) {
+        node.axis = wide.axis;
+        node.thetaO = wide.thetaO;
+    } else if (thetaO >= float(M_PI) || glm::length(rotationAxis) < 1e-6f) {
+        node.axis = wide.axis;
+        node.thetaO = float(M_PI);
+    } else {
+        node.axis = glm::rotate(wide.axis, thetaO - wide.thetaO, glm::normalize(rotationAxis));
+        node.thetaO = thetaO;
+    }
+
+    m_nodes[index] = node;
+    return index;
+}
+
+float LightTree::importance(const Node &node, glm::vec3 point, glm::vec3 normal) const {
+    glm::vec3 center = (node.boundsMin + node.boundsMax) / 2.0f;
+    float radius = glm::length(node.boundsMax - node.boundsMin) / 2.0f;
+    glm::vec3 fromLight = point - center;
+    float distance = glm::length(fromLight);
+    if (distance > node.influence) {
+        return 0.0f;
+    }
+    if (distance <= radius || distance < 1e-6f) {
+        // the point is inside the bounds, so every direction may reach it
+        return node.power;
+    }
+    fromLight /= distance;
+
+    // the closest the node's lights can be, and the attenuation there
+    float closest = distance - radius;
+    float attenuation = std::min(1.0f / (node.function.x + node.function.y * closest + node.function.z * closest * closest), 1.0f);
+
+    // the angle the bounds take up as seen from the point
+    float thetaU = std::asin(radius / distance);
+
+    // how close to the surface's normal the light can arrive
+    float thetaI = std::max(angleBetween(normal, -fromLight) - thetaU, 0.0f);
+    if (thetaI >= float(M_PI) / 2.0f) {
+        return 0.0f;
+    }
+
+    // how close to some light's axis the point can be
+    float theta = std::max(angleBetween(node.axis, fromLight) - node.thetaO - thetaU, 0.0f);
+    if (theta >= node.thetaE) {
+        return 0.0f;
+    }
+
+    return node.power * attenuation * std::cos(thetaI) * std::cos(std::min(theta, float(M_PI) / 2.0f));
+}
+
+int LightTree::sample(glm::vec3 point, glm::vec3 normal, float random, float &pdf) const {
+    pdf = 1.0f;
+    if (m_nodes.empty()) {
+        return -1;
+    }
+
+    int index = 0;
+    while (m_nodes[index].light < 0) {
+        const Node &node = m_nodes[index];
+        float left = importance(m_nodes[node.left], point, normal);
+        float right = importance(m_nodes[node.right], point, normal);
+        if (left + right <= 0.0f) {
+            return -1;
+        }
+
+        // the same random number picks every level, rescaled to what is left of its range
+        float pLeft = left / (left + right);
+        if (random < pLeft) {
+            index = node.left;
+            random = random / pLeft;
+            pdf *= pLeft;
+        } else {
+            index = node.right;
+            random = (random - pLeft) / (1.0f - pLeft);
+            pdf *= 1.0f - pLeft;
+        }
+        random = std::min(random, 0.99999994f);
+    }
+
+    if (importance(m_nodes[index], point, normal) <= 0.0f) {
+        return -1;
+    }
+    return m_nodes[index].light;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include "utils/scenedata.h"
+
+// A bounding volume hierarchy over a scene's point, spot and area lights, for picking a few lights per
+// hit instead of shading every one.
+//
+// Every node bounds its lights' positions with a box, the directions they shine in with a cone (an axis
+// and the angle thetaO around it holding every light's axis, plus the angle thetaE past those axes they
+// still reach), and their power. A node's importance for a point estimates how much light it can send
+// there from those bounds; picking descends from the root, choosing each child in proportion to its
+// importance, so the chosen light's probability is the product of the choices and lights that cannot
+// reach the point are never chosen. A node also bounds its lights' influence radii (see
+// lightInfluenceRadius), so points out of every light's reach are never given one.
+// Directional lights have no position and are left out of the tree.
+
+class LightTree
+{
+public:
+    LightTree() = default;
+    // @param radii The influence radius of each light.
+    LightTree(const std::vector<SceneLightData> &lights, const std::vector<float> &radii);
+
+    // The number of lights in the tree
+    int size() const;
+
+    // The indices of the lights left out of the tree, which every hit shades
+    const std::vector<int>& unboundedLights() const;
+
+    // Picks one light for a point on a surface in proportion to its estimated contribution.
+    // @param random A uniform random number in [0, 1).
+    // @param pdf Receives the probability the light was picked with.
+    // @return The light's index in the lights the tree was built from, or -1 if none can light the point.
+    int sample(glm::vec3 point, glm::vec3 normal, float random, float &pdf) const;
+
+private:
+    struct Node {
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+        glm::vec3 axis;
+        float thetaO;
+        float thetaE;
+        float power;
+        glm::vec3 function; // the weakest attenuation of the node's lights, term by term
+        float influence;    // the distance from the bounds' center past which none of the lights reaches
+        int left = -1;      // children of an inner node
+        int right = -1;
+        int light = -1;     // the light of a leaf
+    };
+
+    // Builds the node for lights [begin, end) of order and returns its index
+    int build(std::vector<int> &order, int begin, int end, const std::vector<SceneLightData> &lights,
+              const std::vector<float> &radii);
+
+    float importance(const Node &node, glm::vec3 point, glm::vec3 normal) const;
+
+    std::vector<Node> m_nodes; // the root first
+    std::vector<int> m_unbounded;
+};
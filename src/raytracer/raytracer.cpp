@@ -1,6 +1,7 @@
 
 #include "raytracer.h"
 #include "raytracescene.h"
+#include "visibilitycache.h"
 #include <glm/glm.hpp>
 #include "utils/shape.h"
 #include "utils/sphere.h"
@@ -9,12 +10,48 @@
 #include "utils/cylinder.h"
 #include "utils/lightmodel.h"
 #include "utils/imagereader.h"
+#include "utils/renderstats.h"
+#include "utils/tracelog.h"
 #include <iostream>
 
 RayTracer::RayTracer(Config config) :
     m_config(config)
 {}
 
+const RayTracer::Config& RayTracer::getConfig() const {
+    return m_config;
+}
+
+void RayTracer::setCostMap(float *costMap, CostMetric metric) {
+    m_costMap = costMap;
+    m_costMetric = metric;
+    m_costStart = std::chrono::steady_clock::now();
+}
+
+void RayTracer::setPrimaryHits(PrimaryHit *primaryHits) {
+    m_primaryHits = primaryHits;
+}
+
+void RayTracer::setVisibilityCache(VisibilityCache *visibility) {
+    m_visibility = visibility;
+}
+
+double RayTracer::costCounter() const {
+    // the thread's statistics only ever grow while it renders, so their differences are a pixel's cost
+    const RenderStats::Stats &stats = RenderStats::local();
+    switch (m_costMetric) {
+    case CostMetric::IntersectionTests:
+        return static_cast<double>(stats.counters[RenderStats::SphereTests] + stats.counters[RenderStats::CubeTests] +
+                                   stats.counters[RenderStats::ConeTests] + stats.counters[RenderStats::CylinderTests]);
+    case CostMetric::Rays:
+        return static_cast<double>(stats.counters[RenderStats::PrimaryRays] + stats.counters[RenderStats::ReflectionRays] +
+                                   stats.counters[RenderStats::RefractionRays] + stats.counters[RenderStats::ShadowRays]);
+    case CostMetric::Nanoseconds:
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - m_costStart).count();
+    }
+    return 0.0;
+}
+
 // Helper function to convert illumination to RGBA, applying some form of tone-mapping (e.g. clamping) in the process
 RGBA toRGBA(const glm::vec4 &illumination) {
     unsigned char r = static_cast<unsigned char>(255 * glm::clamp(illumination.r, 0.0f, 1.0f));
@@ -24,53 +61,30 @@ RGBA toRGBA(const glm::vec4 &illumination) {
     return RGBA{r, g, b};
 }
 
-// Function to create the appropriate shape based on the primitive type and apply the CTM
-std::vector<Shape*> RayTracer::makeShapes(const std::vector<RenderShapeData>& shapeData) {
-    std::vector<Shape*> shapes;
-
-    for (const auto& object : shapeData) {
-        const glm::mat4& ctm = object.ctm;
-        const SceneMaterial& material = object.primitive.material;
-        const glm::vec3 velocity = object.primitive.velocity;
-
-        Image* image;
-        if (material.textureMap.isUsed){
-            image = loadImageFromFile(material.textureMap.filename);
-        }
-        else{
-            image = nullptr;
-        }
-
-        switch (object.primitive.type) {
-        case PrimitiveType::PRIMITIVE_SPHERE:
-            shapes.push_back(new Sphere(ctm, material, velocity, image));
-            break;
-        case PrimitiveType::PRIMITIVE_CUBE:
-            shapes.push_back(new Cube(ctm, material, velocity, image));
-            break;
-        case PrimitiveType::PRIMITIVE_CONE:
-            shapes.push_back(new Cone(ctm, material, velocity, image));
-            break;
-        case PrimitiveType::PRIMITIVE_CYLINDER:
-            shapes.push_back(new Cylinder(ctm, material, velocity, image));
-            break;
-        default:
-            break;
-        }
-    }
+void RayTracer::render(RGBA *imageData, const RayTraceScene &scene) {
+    SceneGeometry geometry;
+    geometry.update(scene.getShapes());
+    render(imageData, scene, geometry);
+}
 
-    return shapes;
+void RayTracer::render(RGBA *imageData, const RayTraceScene &scene, const SceneGeometry &geometry) {
+    renderRegion(imageData, scene, geometry, 0, 0, scene.width(), scene.height());
 }
 
-void RayTracer::render(RGBA *imageData, const RayTraceScene &scene) {
+void RayTracer::renderRegion(RGBA *imageData, const RayTraceScene &scene, const SceneGeometry &geometry,
+                             int x0, int y0, int x1, int y1) {
+    RT_STAT_TIMER(Render);
+    RT_STAT_ADD(Pixels, (x1 - x0) * (y1 - y0));
+    TraceLog::Span span("render tile", "render", TraceLog::isEnabled() ?
+        "{\"x0\": " + std::to_string(x0) + ", \"y0\": " + std::to_string(y0) +
+        ", \"x1\": " + std::to_string(x1) + ", \"y1\": " + std::to_string(y1) + "}" : "");
 
     Camera camera = scene.getCamera();
     glm::vec4 eyePointWorld = glm::inverse(camera.getViewMatrix()) * glm::vec4(0, 0, 0, 1.0f);
     glm::vec3 eyePoint = glm::vec3(eyePointWorld);
 
-    std::vector<Shape*> shapes = makeShapes(scene.getShapes());
-    BoundingBox parentBox(glm::vec3(-20.0f, -20.0f, -20.0f), glm::vec3(20.0f, 20.0f, 20.0f));
-    KdTree::KdNode* root = kdTree.build(shapes, parentBox);
+    KdTree::KdNode* root = geometry.getRoot();
+    m_lastOccluders.assign(scene.getLights().size(), nullptr);
 
     // arbitrary depth value, can change
     int maxDepth = 3;
@@ -78,12 +92,18 @@ void RayTracer::render(RGBA *imageData, const RayTraceScene &scene) {
     int imageWidth = scene.width();
     int imageHeight = scene.height();
 
-    for (int r = 0; r < imageHeight; r ++) {
-        for (int c = 0; c < imageWidth; c ++) {
+    for (int r = y0; r < y1; r ++) {
+        for (int c = x0; c < x1; c ++) {
+            double costBefore = m_costMap != nullptr ? costCounter() : 0.0;
             glm::vec4 color(0,0,0,255);
+
+            // the pixel's first sample records where its primary ray hit
+            glm::vec3 hitOrigin(0.0f), hitDirection(0.0f);
+            float hitDistance = 0.0f;
+            const Shape *hitShape = nullptr;
             if (m_config.enableDepthOfField) {
                 // Number of samples per pixel
-                int samples = 6;  // Increased for better quality
+                int samples = m_config.depthOfFieldSamples;
 
                 for (int s = 0; s < samples; ++s) {
                     float aspectRatio = camera.getAspectRatio();
@@ -123,7 +143,14 @@ void RayTracer::render(RGBA *imageData, const RayTraceScene &scene) {
                     glm::vec3 finalRayDirection = glm::normalize(focalPoint - rayOrigin);
 
                     // dummy unused value for time
-                    color += traceRay(scene, root, rayOrigin, finalRayDirection, maxDepth, 0);
+                    RT_STAT_INC(PrimaryRays);
+                    RT_STAT_INC(PixelSamples);
+                    if (s == 0) {
+                        hitOrigin = rayOrigin;
+                        hitDirection = finalRayDirection;
+                    }
+                    color += traceRay(scene, root, rayOrigin, finalRayDirection, maxDepth, 0, 0.0f,
+                                      s == 0 ? &hitDistance : nullptr, s == 0 ? &hitShape : nullptr);
                 }
                 color /= static_cast<float>(samples);
 
@@ -131,13 +158,18 @@ void RayTracer::render(RGBA *imageData, const RayTraceScene &scene) {
             } else if (m_config.enableMotionBlur) {
                 glm::vec3 d = glm::normalize(camera.getInverseViewMatrix() *
                                                  glm::vec4(scene.getPoint(r, c, camera), 1.0f) - glm::vec4(eyePoint, 1.0f));
-                int samples = 30;
+                hitOrigin = eyePoint;
+                hitDirection = d;
+                int samples = m_config.motionBlurSamples;
                 for (int s = 0; s < samples; ++s) {
 
                     // get a random time within the shutter open and close - start at t = 0 end at t = 1
                     float time = (s + static_cast<float>(rand()) / RAND_MAX) / samples;
 
-                    color += traceRay(scene, root, eyePoint, d, maxDepth, time);
+                    RT_STAT_INC(PrimaryRays);
+                    RT_STAT_INC(PixelSamples);
+                    color += traceRay(scene, root, eyePoint, d, maxDepth, time, 0.0f,
+                                      s == 0 ? &hitDistance : nullptr, s == 0 ? &hitShape : nullptr);
                 }
                 color /= static_cast<float>(samples);
 
@@ -146,11 +178,17 @@ void RayTracer::render(RGBA *imageData, const RayTraceScene &scene) {
                 glm::vec3 d = glm::normalize(scene.getPoint(r, c, camera));
                 glm::vec3 eyePointLens;
                 glm::vec3 dLens;
+                RT_STAT_INC(PixelSamples);
+                RT_STAT_INC(LensRays);
                 if (!traceRayThroughLens(glm::vec3(0.0f), d, &eyePointLens, &dLens, scene.getLensInterfaces())) {
+                    RT_STAT_INC(LensRejectedRays);
                     color = glm::vec4(0, 0, 0, 255);
                 } else {
                     d = glm::normalize(camera.getInverseViewMatrix() * glm::vec4(dLens, 0.0f));
-                    color = traceRay(scene, root, camera.getInverseViewMatrix() * glm::vec4(eyePointLens, 1.0f), d, maxDepth, 0);
+                    hitOrigin = glm::vec3(camera.getInverseViewMatrix() * glm::vec4(eyePointLens, 1.0f));
+                    hitDirection = d;
+                    RT_STAT_INC(PrimaryRays);
+                    color = traceRay(scene, root, hitOrigin, d, maxDepth, 0, 0.0f, &hitDistance, &hitShape);
                 }
             }
             else {
@@ -158,8 +196,13 @@ void RayTracer::render(RGBA *imageData, const RayTraceScene &scene) {
                 glm::vec3 d = glm::normalize(camera.getInverseViewMatrix() *
                                                  glm::vec4(scene.getPoint(r, c, camera), 1.0f) - glm::vec4(eyePoint, 1.0f));
 
+                hitOrigin = eyePoint;
+                hitDirection = d;
+
                 // dummy unused value for time
-                color = traceRay(scene, root, eyePoint, d, maxDepth, 0);
+                RT_STAT_INC(PrimaryRays);
+                RT_STAT_INC(PixelSamples);
+                color = traceRay(scene, root, eyePoint, d, maxDepth, 0, 0.0f, &hitDistance, &hitShape);
 
             }
             RGBA finalColor;
@@ -169,12 +212,63 @@ void RayTracer::render(RGBA *imageData, const RayTraceScene &scene) {
             finalColor.a = 255;
 
             imageData[r * imageWidth + c] = finalColor;
+
+            if (m_primaryHits != nullptr) {
+                m_primaryHits[r * imageWidth + c] =
+                    PrimaryHit{hitShape, hitShape != nullptr ? hitOrigin + hitDistance * hitDirection : glm::vec3(0.0f)};
+            }
+            if (m_costMap != nullptr) {
+                m_costMap[r * imageWidth + c] += static_cast<float>(costCounter() - costBefore);
+            }
         }
 
     }
 }
 
-glm::vec4 RayTracer::traceRay(const RayTraceScene &scene, KdTree::KdNode* root, const glm::vec3 eyePoint, const glm::vec3 d, int currentDepth, float time) {
+void RayTracer::captureLightField(LightField &lightField, const RayTraceScene &scene) {
+    SceneGeometry geometry;
+    geometry.update(scene.getShapes());
+    captureLightField(lightField, scene, geometry);
+}
+
+void RayTracer::captureLightField(LightField &lightField, const RayTraceScene &scene, const SceneGeometry &geometry) {
+    RT_STAT_TIMER(Render);
+    RT_STAT_ADD(Pixels, scene.width() * scene.height());
+    TraceLog::Span span("capture light field", "render");
+    const Camera &camera = scene.getCamera();
+    KdTree::KdNode* root = geometry.getRoot();
+    m_lastOccluders.assign(scene.getLights().size(), nullptr);
+
+    int maxDepth = 3;
+    int samples = m_config.lightFieldSamples;
+
+    lightField.reset(camera, scene.width(), scene.height(), samples);
+
+    for (int r = 0; r < scene.height(); r++) {
+        for (int c = 0; c < scene.width(); c++) {
+            double costBefore = m_costMap != nullptr ? costCounter() : 0.0;
+            for (int s = 0; s < samples; s++) {
+                glm::vec2 jitter(static_cast<float>(rand()) / RAND_MAX - 0.5f,
+                                 static_cast<float>(rand()) / RAND_MAX - 0.5f);
+                glm::vec2 lensPoint = glm::vec2(camera.random_in_unit_disk());
+
+                glm::vec3 rayOrigin, rayDirection;
+                lightField.primaryRay(r, c, jitter, lensPoint, rayOrigin, rayDirection);
+
+                float depth;
+                RT_STAT_INC(PrimaryRays);
+                RT_STAT_INC(PixelSamples);
+                glm::vec4 color = traceRay(scene, root, rayOrigin, rayDirection, maxDepth, 0, 0.0f, &depth);
+                lightField.store(r, c, s, color, depth, jitter, lensPoint);
+            }
+            if (m_costMap != nullptr) {
+                m_costMap[r * scene.width() + c] += static_cast<float>(costCounter() - costBefore);
+            }
+        }
+    }
+}
+
+glm::vec4 RayTracer::traceRay(const RayTraceScene &scene, KdTree::KdNode* root, const glm::vec3 eyePoint, const glm::vec3 d, int currentDepth, float time, float pathLength, float *hitDistance, const Shape **hitShape) {
 
     const Camera& camera = scene.getCamera();
 
@@ -201,7 +295,15 @@ glm::vec4 RayTracer::traceRay(const RayTraceScene &scene, KdTree::KdNode* root,
         }
     }
 
+    if (hitDistance != nullptr) {
+        *hitDistance = closestShape != nullptr ? closestT : std::numeric_limits<float>::infinity();
+    }
+    if (hitShape != nullptr) {
+        *hitShape = closestShape;
+    }
+
     if (closestShape != nullptr) {
+        RT_STAT_INC(Hits);
         glm::vec3 normal = closestShape->calcNormal(closestIntersection);
         const float epsilon = 1e-2f;
         glm::vec3 offsetIntersection = closestIntersection + epsilon * normal;
@@ -211,100 +313,51 @@ glm::vec4 RayTracer::traceRay(const RayTraceScene &scene, KdTree::KdNode* root,
         glm::vec3 ambient = scene.getGlobalData().ka * closestShape->getMaterial().cAmbient;
         glm::vec4 illumination = glm::vec4(ambient, 1.0f);
 
-        for (const SceneLightData &light : scene.getLights()) {
-            if (light.type == LightType::LIGHT_AREA) {
-                // Sample multiple points on the area light for soft shadows
-                const int shadowSamples = 8; // Can be adjusted
-                float shadowFactor = 0.0f;
-
-                glm::vec3 lightNormal = glm::normalize(glm::vec3(light.dir));
-                glm::vec3 lightU = glm::normalize(glm::cross(lightNormal, glm::vec3(0, 1, 0)));
-                if (glm::length(lightU) < 0.1f) {
-                    lightU = glm::normalize(glm::cross(lightNormal, glm::vec3(1, 0, 0)));
-                }
-                glm::vec3 lightV = glm::cross(lightNormal, lightU);
-
-                for (int s = 0; s < shadowSamples; s++) {
-                    float u = (static_cast<float>(rand()) / RAND_MAX - 0.5f);
-                    float v = (static_cast<float>(rand()) / RAND_MAX - 0.5f);
-
-                    glm::vec3 samplePos = glm::vec3(light.pos) +
-                                          (u * light.width * lightU) +
-                                          (v * light.height * lightV);
-
-                    glm::vec3 shadowDir = glm::normalize(samplePos - offsetIntersection);
-                    float maxDist = glm::length(samplePos - offsetIntersection);
-
-                    bool sampleInShadow = false;
-                    for (const auto shadowShape : shapes) {
-                        float shadowT;
-                        glm::vec3 shadowIntersection;
-
-                        if (shadowShape->calcIntersection(offsetIntersection, shadowDir,
-                                                          shadowIntersection, shadowT, 0, velocity)) {
-                            float shadowDist = glm::length(shadowIntersection - offsetIntersection);
-                            if (shadowDist < maxDist) {
-                                sampleInShadow = true;
-                                break;
-                            }
-                        }
-                    }
-                    if (!sampleInShadow) {
-                        shadowFactor += 1.0f;
-                    }
-                }
-                shadowFactor /= static_cast<float>(shadowSamples);
-
-                if (shadowFactor > 0.0f) {
-                    // std::cout << "Shadow factor: " << shadowFactor << std::endl;
-                    glm::vec4 lightContribution = phong(scene, closestIntersection, normal,
-                                                        directionToCamera, closestShape->getMaterial(),
-                                                        light, closestShape->getTexture(closestIntersection));
-                    // std::cout << "Light contribution: " << lightContribution.x << ", " << lightContribution.y << ", " << lightContribution.z << std::endl;
-                    illumination += lightContribution * shadowFactor;
-                    // std::cout << "Accumulated illumination: " << illumination.x << ", " << illumination.y << ", " << illumination.z << std::endl;
-                }
-            }else{
-                glm::vec3 lightDirection;
-                float maxDistance = std::numeric_limits<float>::max();
-
-                if (light.type == LightType::LIGHT_POINT || light.type == LightType::LIGHT_SPOT) {
-                    lightDirection = glm::normalize(glm::vec3(light.pos) - offsetIntersection);
-                    maxDistance = glm::length(glm::vec3(light.pos) - offsetIntersection);
-                } else {
-                    lightDirection = glm::normalize(glm::vec3(-light.dir));
-                }
-
-                bool isInShadow = false;
-
-                for (const auto shadowShape : shapes) {
-                    float shadowT;
-                    glm::vec3 shadowIntersection;
-
-                    // calculate shadows based on the shape's position at time = 0
-                    if (shadowShape->calcIntersection(offsetIntersection, lightDirection, shadowIntersection, shadowT, 0, velocity)) {
-                        float shadowDistance = glm::length(shadowIntersection - offsetIntersection);
+        // a filtered lookup averages the texels a pixel's cone covers after travelling the whole path to the hit,
+        // so a texture seen in a mirror is as blurred as it would be that far from the camera
+        float footprint = 0.0f;
+        if (m_config.enableTextureFilter) {
+            footprint = (pathLength + closestT) * 2.0f * std::tan(camera.getHeightAngle() / 2.0f) / scene.height();
+        }
+        glm::vec3 texture = closestShape->getTexture(closestIntersection, footprint);
 
-                        if (shadowDistance < maxDistance || light.type == LightType::LIGHT_DIRECTIONAL) {
-                            isInShadow = true;
-                            break;
-                        }
-                    }
-                }
+        ShadingPoint point{closestIntersection, offsetIntersection, normal, directionToCamera,
+                           &closestShape->getMaterial(), texture, velocity, &shapes};
 
-                if (!isInShadow) {
-                    glm::vec4 lightContribution = phong(scene, closestIntersection, normal, directionToCamera,
-                                                        closestShape->getMaterial(), light, closestShape->getTexture(closestIntersection));
-                    illumination += lightContribution;
+        // each depth keeps its own points on area lights, reused from hit to hit
+        if ((int)m_lightSamples.size() <= currentDepth) {
+            m_lightSamples.resize(currentDepth + 1);
+        }
+        std::vector<LightSample> &lightSamples = m_lightSamples[currentDepth];
+
+        const std::vector<SceneLightData> &lights = scene.getLights();
+        const LightTree &lightTree = scene.getLightTree();
+        if (m_config.lightTreeSamples > 0 && lightTree.size() > m_config.lightTreeSamples) {
+            // a few lights picked in proportion to their estimated contribution stand for all of the tree's
+            for (int l : lightTree.unboundedLights()) {
+                illumination += shadeLight(scene, l, point, lightSamples);
+            }
+            for (int s = 0; s < m_config.lightTreeSamples; s++) {
+                float pdf;
+                int l = lightTree.sample(offsetIntersection, normal, static_cast<float>(rand()) / (static_cast<float>(RAND_MAX) + 1.0f), pdf);
+                if (l >= 0) {
+                    glm::vec4 lightContribution = shadeLight(scene, l, point, lightSamples);
+                    illumination += glm::vec4(glm::vec3(lightContribution) / (pdf * m_config.lightTreeSamples), 0.0f);
                 }
             }
+        } else {
+            for (int l = 0; l < (int)lights.size(); l++) {
+                illumination += shadeLight(scene, l, point, lightSamples);
+            }
         }
 
         glm::vec4 reflectivity = closestShape->getMaterial().cReflective;
         if (reflectivity.r > 0.0f || reflectivity.g > 0.0f || reflectivity.b > 0.0f) {
             if (currentDepth < 4){
                 glm::vec3 reflectionDir = glm::reflect(d, normal);
-                glm::vec4 reflectionColor = traceRay(scene, root, offsetIntersection, reflectionDir, currentDepth + 1, time);
+                RT_STAT_INC(ReflectionRays);
+                glm::vec4 reflectionColor = traceRay(scene, root, offsetIntersection, reflectionDir, currentDepth + 1, time,
+                                                     pathLength + closestT);
 
                 illumination += glm::vec4(
                     scene.getGlobalData().ks * reflectivity.r * (reflectionColor.r / 255.0f),
@@ -335,7 +388,8 @@ glm::vec4 RayTracer::traceRay(const RayTraceScene &scene, KdTree::KdNode* root,
             }
 
             glm::vec3 refOffset = closestIntersection + epsilon * T;
-            glm::vec4 refractionColor = traceRay(scene, root, refOffset, T, currentDepth + 1, time);
+            RT_STAT_INC(RefractionRays);
+            glm::vec4 refractionColor = traceRay(scene, root, refOffset, T, currentDepth + 1, time, pathLength + closestT);
 
             illumination.r = glm::mix(illumination.r, refractionColor.r / 255.0f, transparency.r * scene.getGlobalData().kt);
             illumination.g = glm::mix(illumination.g, refractionColor.g / 255.0f, transparency.g * scene.getGlobalData().kt);
@@ -349,6 +403,98 @@ glm::vec4 RayTracer::traceRay(const RayTraceScene &scene, KdTree::KdNode* root,
     }
 }
 
+glm::vec4 RayTracer::shadeLight(const RayTraceScene &scene, int lightIndex, const ShadingPoint &point,
+                                std::vector<LightSample> &lightSamples) {
+    const SceneLightData &light = scene.getLights()[lightIndex];
+    glm::vec4 illumination(0.0f);
+    if (m_lastOccluders.size() != scene.getLights().size()) {
+        m_lastOccluders.assign(scene.getLights().size(), nullptr);
+    }
+
+    // lights too dim to matter here, or whose cone misses the point, need no shadow rays
+    if (!lightReaches(light, scene.getLightRadii()[lightIndex], point.offsetPosition)) {
+        RT_STAT_INC(CulledLights);
+        return illumination;
+    }
+
+    if (light.type == LightType::LIGHT_AREA) {
+        // one set of points on the light serves both the shadow rays and the shading
+        int sampleCount = areaLightSampleCount(light, m_config.areaLightSamples);
+        sampleAreaLight(light, point.offsetPosition, sampleCount, lightSamples);
+        float area = areaLightArea(light);
+
+        for (const LightSample &sample : lightSamples) {
+            glm::vec4 sampleContribution = phongSample(scene, point.normal, point.directionToCamera, *point.material,
+                                                       light, point.texture, sample);
+            // points behind the surface add nothing, so they need no shadow ray
+            if (sampleContribution == glm::vec4(0.0f)) {
+                continue;
+            }
+
+            if (occluded(point, lightIndex, sample.direction, sample.distance)) {
+                continue;
+            }
+            illumination += sampleContribution / (sample.pdf * area * sampleCount);
+        }
+        return illumination;
+    }
+
+    glm::vec3 lightDirection;
+    // anything in the way of a directional light blocks it
+    float maxDistance = std::numeric_limits<float>::infinity();
+
+    if (light.type == LightType::LIGHT_POINT || light.type == LightType::LIGHT_SPOT) {
+        lightDirection = glm::normalize(glm::vec3(light.pos) - point.offsetPosition);
+        maxDistance = glm::length(glm::vec3(light.pos) - point.offsetPosition);
+    } else {
+        lightDirection = glm::normalize(glm::vec3(-light.dir));
+    }
+
+    // calculate shadows based on the shape's position at time = 0
+    if (occluded(point, lightIndex, lightDirection, maxDistance)) {
+        return illumination;
+    }
+
+    return phong(scene, point.position, point.normal, point.directionToCamera, *point.material, light, point.texture);
+}
+
+bool RayTracer::occluded(const ShadingPoint &point, int lightIndex, glm::vec3 direction, float maxDistance) {
+    RT_STAT_INC(ShadowRays);
+    Shape *&lastOccluder = m_lastOccluders[lightIndex];
+
+    // whether shape blocks the shadow ray
+    auto blocks = [&](Shape *shape) {
+        float shadowT;
+        glm::vec3 shadowIntersection;
+
+        return shape->calcIntersection(point.offsetPosition, direction, shadowIntersection, shadowT, 0, point.velocity) &&
+               glm::length(shadowIntersection - point.offsetPosition) < maxDistance;
+    };
+
+    // neighbouring points are usually shadowed by the same shape, so it is tested first
+    if (lastOccluder != nullptr) {
+        if (blocks(lastOccluder)) {
+            RT_STAT_INC(OccluderCacheHits);
+            return true;
+        }
+        RT_STAT_INC(OccluderCacheMisses);
+    }
+
+    // the visibility cache narrows the shapes down to those that can reach the ray
+    const std::vector<Shape*> *candidates = point.shapes;
+    if (m_visibility != nullptr && m_visibility->occluders(lightIndex, point.offsetPosition, m_shadowCandidates)) {
+        candidates = &m_shadowCandidates;
+    }
+
+    for (Shape *shape : *candidates) {
+        if (shape != lastOccluder && blocks(shape)) {
+            lastOccluder = shape;
+            return true;
+        }
+    }
+    return false;
+}
+
 bool RayTracer::traceRayThroughLens(const glm::vec3 eyePoint, const glm::vec3 d, glm::vec3 *eyePointOut, glm::vec3 *dOut, std::vector<LensInterface> lenses) {
     glm::vec3 dLens = d;
     glm::vec3 eyePointLens = eyePoint;
@@ -4,13 +4,18 @@
 #include <glm/glm.hpp>
 #include "utils/rgba.h"
 #include "utils/shape.h"
+#include "utils/lightsampler.h"
 #include "raytracescene.h"
 #include "kdtree.h"
+#include "lightfield.h"
+#include "scenegeometry.h"
+#include <chrono>
 #include <random>
 
 // A forward declaration for the RaytraceScene class
 
 class RayTraceScene;
+class VisibilityCache;
 
 // A class representing a ray-tracer
 
@@ -34,12 +39,49 @@ public:
         int maxRecursiveDepth    = 4;
         bool onlyRenderNormals   = false;
         bool samples_per_pixel = 100;
+        int lightFieldSamples    = 8;
+
+        // samples per pixel (or per shading point, for area lights) of the stochastic effects
+        int depthOfFieldSamples  = 6;
+        int motionBlurSamples    = 30;
+        int areaLightSamples     = 8;
+
+        // lights picked per hit from the scene's light tree, in proportion to their estimated
+        // contribution; 0 (or a scene with no more lights than that) shades every light
+        int lightTreeSamples     = 0;
+    };
+
+    // Where a pixel's primary ray hit; with several samples per pixel, the first sample's (the one nearest
+    // the start of the shutter)
+    struct PrimaryHit {
+        const Shape *shape;  // null on a miss
+        glm::vec3 position;  // world-space hit point
+    };
+
+    // What a per-pixel cost map records; tests and rays are read from the thread's RenderStats,
+    // so they stay at 0 unless the build defines RT_ENABLE_STATS
+    enum class CostMetric {
+        IntersectionTests, // primitive intersection tests of every ray the pixel spawned
+        Rays,              // rays of every kind the pixel spawned
+        Nanoseconds        // time spent on the pixel
     };
 
 public:
     RayTracer(Config config);
 
-    std::vector<Shape*> makeShapes(const std::vector<RenderShapeData>& shapeData);
+    const Config& getConfig() const;
+
+    // Adds the cost of every pixel rendered from now on to costMap (scene width * height values, row by row),
+    // or stops recording if costMap is null.
+    void setCostMap(float *costMap, CostMetric metric = CostMetric::IntersectionTests);
+
+    // Records the primary hit of every pixel rendered from now on in primaryHits (scene width * height values,
+    // row by row), or stops recording if primaryHits is null.
+    void setPrimaryHits(PrimaryHit *primaryHits);
+
+    // Tests shadow rays only against the shapes visibility says they could hit, or against every shape if null.
+    // The cache must have been updated for the scene and geometry being rendered.
+    void setVisibilityCache(VisibilityCache *visibility);
 
     // Renders the scene synchronously.
     // The ray-tracer will render the scene and fill imageData in-place.
@@ -47,7 +89,27 @@ public:
     // @param scene The scene to be rendered.
     void render(RGBA *imageData, const RayTraceScene &scene);
 
-    glm::vec4 traceRay(const RayTraceScene &scene, KdTree::KdNode* root, const glm::vec3 eyePoint, const glm::vec3 d, int currentDepth, float time);
+    // Renders the scene with shapes that were already built, e.g. kept from the previous frame of a sequence.
+    // @param geometry The shapes and acceleration structure of the scene.
+    void render(RGBA *imageData, const RayTraceScene &scene, const SceneGeometry &geometry);
+
+    // Renders only the pixels in columns [x0, x1) and rows [y0, y1), leaving the rest of imageData untouched.
+    void renderRegion(RGBA *imageData, const RayTraceScene &scene, const SceneGeometry &geometry,
+                      int x0, int y0, int x1, int y1);
+
+    // Traces every depth of field sample of the scene once and stores it in lightField,
+    // from which refocused and re-apertured images can be synthesized without new rays.
+    // @param lightField The light field to be filled.
+    // @param scene The scene to be captured; its camera sets the capture aperture and focal length.
+    void captureLightField(LightField &lightField, const RayTraceScene &scene);
+    void captureLightField(LightField &lightField, const RayTraceScene &scene, const SceneGeometry &geometry);
+
+    // @param pathLength How far the ray has already travelled from the camera, through the reflections and
+    //                   refractions that led to it; texture footprints grow with the whole path.
+    // @param hitDistance If not null, receives the distance to the closest hit, or infinity on a miss.
+    // @param hitShape If not null, receives the closest shape hit, or null on a miss.
+    glm::vec4 traceRay(const RayTraceScene &scene, KdTree::KdNode* root, const glm::vec3 eyePoint, const glm::vec3 d, int currentDepth, float time,
+                       float pathLength = 0.0f, float *hitDistance = nullptr, const Shape **hitShape = nullptr);
 
     bool traceRayThroughLens(const glm::vec3 eyePoint, const glm::vec3 d, glm::vec3 *eyePointOut, glm::vec3 *dOut, std::vector<LensInterface> lenses);
 
@@ -55,6 +117,46 @@ public:
 
 
 private:
+    // A hit being shaded, and the shapes its shadow rays are tested against
+    struct ShadingPoint {
+        glm::vec3 position;
+        glm::vec3 offsetPosition; // moved off the surface along the normal, where shadow rays start
+        glm::vec3 normal;
+        glm::vec3 directionToCamera;
+        const SceneMaterial *material; // the hit shape's
+        glm::vec3 texture;
+        float velocity;
+        const std::vector<Shape*> *shapes;
+    };
+
+    // The light one of the scene's lights sends to a hit, with shadows
+    // @param lightSamples Scratch space for the points drawn on an area light.
+    glm::vec4 shadeLight(const RayTraceScene &scene, int lightIndex, const ShadingPoint &point,
+                         std::vector<LightSample> &lightSamples);
+
+    // Whether a shadow ray from point towards one of the scene's lights is blocked within maxDistance,
+    // testing the shape that last blocked a ray towards the same light first.
+    bool occluded(const ShadingPoint &point, int lightIndex, glm::vec3 direction, float maxDistance);
+
     const Config m_config;
     KdTree kdTree;
+
+    // The shape that last blocked a shadow ray towards each of the scene's lights, or null. A ray-tracer renders
+    // on one thread, so this is per thread; it is cleared whenever rendering starts, as shapes may have changed.
+    std::vector<Shape*> m_lastOccluders;
+
+    VisibilityCache *m_visibility = nullptr;
+    std::vector<Shape*> m_shadowCandidates; // scratch space for the visibility cache's answers
+
+    // Scratch space for the points drawn on area lights, one buffer per recursion depth
+    std::vector<std::vector<LightSample>> m_lightSamples;
+
+    PrimaryHit *m_primaryHits = nullptr;
+
+    // The running total of the cost map's metric; a pixel's cost is how much it grew while rendering it
+    double costCounter() const;
+
+    float *m_costMap = nullptr;
+    CostMetric m_costMetric = CostMetric::IntersectionTests;
+    std::chrono::steady_clock::time_point m_costStart;
 };
@@ -1,8 +1,19 @@
 #include "raytracescene.h"
+#include "utils/lightmodel.h"
+
+// Helper function returning the influence radius of every light
+std::vector<float> influenceRadii(const std::vector<SceneLightData> &lights) {
+    std::vector<float> radii;
+    for (const SceneLightData &light : lights) {
+        radii.push_back(lightInfluenceRadius(light));
+    }
+    return radii;
+}
 
 RayTraceScene::RayTraceScene(int width, int height, const RenderData &metaData)
     : m_width(width), m_height(height), m_globalData(metaData.globalData), m_camera(width, height, metaData),
-    shapes(metaData.shapes), lights(metaData.lights), lensInterfaces(metaData.lensInterfaces) {}
+    shapes(metaData.shapes), lights(metaData.lights), lensInterfaces(metaData.lensInterfaces),
+    lightRadii(influenceRadii(lights)), lightTree(lights, lightRadii) {}
 
 // Getter for width
 const int& RayTraceScene::width() const {
@@ -34,6 +45,16 @@ const std::vector<SceneLightData>& RayTraceScene::getLights() const {
     return lights;
 }
 
+// Getter for the lights' influence radii
+const std::vector<float>& RayTraceScene::getLightRadii() const {
+    return lightRadii;
+}
+
+// Getter for the light tree
+const LightTree& RayTraceScene::getLightTree() const {
+    return lightTree;
+}
+
 const glm::vec3 RayTraceScene::getPoint(float r, float c, const Camera& camera) const {
     float viewPlaneHeight = 2 * camera.getFocalLength() * tan(camera.getHeightAngle() / 2.0f);
     float viewPlaneWidth = 2 * camera.getFocalLength() * tan(camera.getWidthAngle() / 2.0f);
@@ -3,6 +3,7 @@
 #include "utils/scenedata.h"
 #include "utils/sceneparser.h"
 #include "camera/camera.h"
+#include "lighttree.h"
 
 // A class representing a scene to be ray-traced
 
@@ -20,6 +21,8 @@ private:
     std::vector<RenderShapeData> shapes;
     std::vector<SceneLightData> lights;
     std::vector<LensInterface> lensInterfaces;
+    std::vector<float> lightRadii;
+    LightTree lightTree;
 public:
     RayTraceScene(int width, int height, const RenderData &metaData);
 
@@ -39,6 +42,12 @@ public:
 
     const std::vector<SceneLightData>& getLights() const;
 
+    // The influence radius of each light (see lightInfluenceRadius), computed along with the scene
+    const std::vector<float>& getLightRadii() const;
+
+    // The hierarchy over the lights, built along with the scene
+    const LightTree& getLightTree() const;
+
     const glm::vec3 getPoint(float i, float j, const Camera& camera) const;
 
     const std::vector<LensInterface>& getLensInterfaces() const;
@@ -0,0 +1,142 @@
+#include "scenegeometry.h"
+#include "utils/sphere.h"
+#include "utils/cube.h"
+#include "utils/cone.h"
+#include "utils/cylinder.h"
+#include "utils/renderstats.h"
+#include "utils/tracelog.h"
+
+// Helper function to compare the parts of a texture map that affect the built shape
+bool sameFileMap(const SceneFileMap &a, const SceneFileMap &b) {
+    return a.isUsed == b.isUsed && a.filename == b.filename &&
+           a.repeatU == b.repeatU && a.repeatV == b.repeatV;
+}
+
+bool SceneGeometry::sameShape(const RenderShapeData &a, const RenderShapeData &b) {
+    const SceneMaterial &m = a.primitive.material;
+    const SceneMaterial &n = b.primitive.material;
+
+    return a.primitive.type == b.primitive.type &&
+           a.primitive.velocity == b.primitive.velocity &&
+           a.ctm == b.ctm &&
+           m.cAmbient == n.cAmbient && m.cDiffuse == n.cDiffuse && m.cSpecular == n.cSpecular &&
+           m.shininess == n.shininess && m.cReflective == n.cReflective &&
+           m.cTransparent == n.cTransparent && m.ior == n.ior &&
+           m.blend == n.blend && sameFileMap(m.textureMap, n.textureMap);
+}
+
+SceneGeometry::SceneGeometry(TextureCache *textures)
+    : m_textures(textures), m_ownTextures(nullptr), m_root(nullptr)
+{
+    if (m_textures == nullptr) {
+        m_ownTextures = new TextureCache();
+        m_textures = m_ownTextures;
+    }
+}
+
+SceneGeometry::~SceneGeometry() {
+    clear();
+    delete m_ownTextures;
+}
+
+void SceneGeometry::clear() {
+    m_kdTree.release(m_root);
+    m_root = nullptr;
+
+    for (Shape* shape : m_shapes) {
+        delete shape;
+    }
+    m_shapes.clear();
+    m_shapeTextures.clear();
+    m_shapeData.clear();
+}
+
+// Function to create the appropriate shape based on the primitive type and apply the CTM
+Shape* SceneGeometry::makeShape(const RenderShapeData &object, const Image *image) {
+    const glm::mat4& ctm = object.ctm;
+    const SceneMaterial& material = object.primitive.material;
+    const glm::vec3 velocity = object.primitive.velocity;
+
+    switch (object.primitive.type) {
+    case PrimitiveType::PRIMITIVE_SPHERE:
+        return new Sphere(ctm, material, velocity, image);
+    case PrimitiveType::PRIMITIVE_CUBE:
+        return new Cube(ctm, material, velocity, image);
+    case PrimitiveType::PRIMITIVE_CONE:
+        return new Cone(ctm, material, velocity, image);
+    case PrimitiveType::PRIMITIVE_CYLINDER:
+        return new Cylinder(ctm, material, velocity, image);
+    default:
+        return nullptr;
+    }
+}
+
+std::vector<int> SceneGeometry::update(const std::vector<RenderShapeData> &shapeData) {
+    RT_STAT_TIMER(Build);
+    TraceLog::Span span("build geometry", "build");
+    std::vector<int> changed;
+    m_generation++;
+
+    // shapes are matched by their position in the scene; a different count means a different scene
+    if (shapeData.size() != m_shapeData.size()) {
+        clear();
+        m_shapes.resize(shapeData.size(), nullptr);
+        m_shapeTextures.resize(shapeData.size());
+    }
+
+    std::vector<std::string> textureFiles;
+    for (int i = 0; i < (int)shapeData.size(); i++) {
+        if (i < (int)m_shapeData.size() && sameShape(shapeData[i], m_shapeData[i])) {
+            continue;
+        }
+        changed.push_back(i);
+
+        const SceneFileMap &textureMap = shapeData[i].primitive.material.textureMap;
+        if (textureMap.isUsed) {
+            textureFiles.push_back(textureMap.filename);
+        }
+    }
+
+    // every texture the new shapes need is decoded up front, distinct files in parallel
+    std::map<std::string, std::shared_ptr<const Image>> textures = m_textures->getAll(textureFiles);
+
+    for (int i : changed) {
+        const SceneFileMap &textureMap = shapeData[i].primitive.material.textureMap;
+        std::shared_ptr<const Image> texture = textureMap.isUsed ? textures[textureMap.filename] : nullptr;
+
+        delete m_shapes[i];
+        m_shapes[i] = makeShape(shapeData[i], texture.get());
+        m_shapeTextures[i] = texture;
+    }
+    m_shapeData = shapeData;
+
+    if (changed.empty() && m_root != nullptr) {
+        return changed;
+    }
+
+    // unsupported primitives produce no shape and are left out of the tree
+    std::vector<Shape*> shapes;
+    for (Shape* shape : m_shapes) {
+        if (shape != nullptr) {
+            shapes.push_back(shape);
+        }
+    }
+
+    m_kdTree.release(m_root);
+    BoundingBox parentBox(glm::vec3(-20.0f, -20.0f, -20.0f), glm::vec3(20.0f, 20.0f, 20.0f));
+    m_root = m_kdTree.build(shapes, parentBox);
+
+    return changed;
+}
+
+const std::vector<Shape*>& SceneGeometry::getShapes() const {
+    return m_shapes;
+}
+
+KdTree::KdNode* SceneGeometry::getRoot() const {
+    return m_root;
+}
+
+std::uint64_t SceneGeometry::getGeneration() const {
+    return m_generation;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "kdtree.h"
+#include "utils/sceneparser.h"
+#include "utils/shape.h"
+#include "utils/texturecache.h"
+
+// A class owning the shapes and acceleration structure built for a scene.
+// Updating it with the next frame of a sequence only rebuilds the shapes whose data changed,
+// and textures are looked up in a cache that can be shared between frames. The geometry shares
+// ownership of its shapes' textures, so they are freed with the last geometry using them.
+
+class SceneGeometry
+{
+public:
+    // @param textures The texture cache to decode textures through. If null, the geometry
+    //                 uses its own cache, which is freed along with it.
+    SceneGeometry(TextureCache *textures = nullptr);
+    ~SceneGeometry();
+
+    SceneGeometry(const SceneGeometry &) = delete;
+    SceneGeometry &operator=(const SceneGeometry &) = delete;
+
+    // Builds the shapes for shapeData, keeping the shapes from the previous update whose data is unchanged.
+    // @return The indices of the shapes that were (re)built.
+    std::vector<int> update(const std::vector<RenderShapeData> &shapeData);
+
+    // The shapes in the same order as the shape data; unsupported primitives have a null entry.
+    const std::vector<Shape*>& getShapes() const;
+
+    KdTree::KdNode* getRoot() const;
+
+    // How many times update has been called. Anything that keeps pointers to the shapes across frames
+    // can tell from it whether an update it did not see may have freed some of them.
+    std::uint64_t getGeneration() const;
+
+    // Whether a shape with data a can be kept when the next frame has data b
+    static bool sameShape(const RenderShapeData &a, const RenderShapeData &b);
+
+private:
+    Shape* makeShape(const RenderShapeData &object, const Image *image);
+    void clear();
+
+    TextureCache *m_textures;
+    TextureCache *m_ownTextures;
+
+    std::vector<RenderShapeData> m_shapeData;
+    std::vector<Shape*> m_shapes;
+    std::vector<std::shared_ptr<const Image>> m_shapeTextures; // the texture of each shape, or null
+
+    KdTree m_kdTree;
+    KdTree::KdNode* m_root;
+
+    std::uint64_t m_generation = 0;
+};
@@ -0,0 +1,150 @@
+#include "temporalaccumulator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_map>
+
+TemporalAccumulator::TemporalAccumulator(int maxHistory)
+    : m_maxHistory(std::max(maxHistory, 1))
+{}
+
+void TemporalAccumulator::setMaxHistory(int maxHistory) {
+    m_maxHistory = std::max(maxHistory, 1);
+}
+
+int TemporalAccumulator::previousPixel(const glm::vec3 &cameraPoint) const {
+    if (cameraPoint.z >= 0.0f) {
+        return -1;
+    }
+
+    // the inverse of RayTraceScene::getPoint, which the surfaces were found through
+    float x = cameraPoint.x / -cameraPoint.z / (2.0f * m_tanX);
+    float y = cameraPoint.y / -cameraPoint.z / (2.0f * m_tanY);
+    int c = static_cast<int>(std::floor((x + 0.5f) * m_width));
+    int r = static_cast<int>(std::floor(m_height - (y + 0.5f) * m_height));
+
+    if (c < 0 || c >= m_width || r < 0 || r >= m_height) {
+        return -1;
+    }
+    return r * m_width + c;
+}
+
+int TemporalAccumulator::reproject(const Surface &surface, const glm::vec3 &direction) const {
+    if (surface.shape < 0) {
+        // the background is infinitely far away, so only the camera's rotation moves it
+        int pixel = previousPixel(glm::vec3(m_viewMatrix * glm::vec4(direction, 0.0f)));
+        return pixel >= 0 && m_surfaces[pixel].shape < 0 ? pixel : -1;
+    }
+
+    // the same point on the shape, where the shape was in the previous frame
+    glm::vec4 previousWorld = m_shapes[surface.shape].ctm * glm::vec4(surface.objectPoint, 1.0f);
+    glm::vec3 previousCamera = glm::vec3(m_viewMatrix * previousWorld);
+
+    int pixel = previousPixel(previousCamera);
+    if (pixel < 0) {
+        return -1;
+    }
+
+    // something else was in front of the point, or the point was on another side of the shape
+    const Surface &previous = m_surfaces[pixel];
+    float expected = glm::length(previousCamera);
+    if (previous.shape != surface.shape || std::abs(previous.distance - expected) > 0.02f * expected + 0.01f) {
+        return -1;
+    }
+    return pixel;
+}
+
+int TemporalAccumulator::render(RayTracer &raytracer, RGBA *imageData, const RayTraceScene &scene, const SceneGeometry &geometry) {
+    const RayTracer::Config &config = raytracer.getConfig();
+    const Camera &camera = scene.getCamera();
+    const std::vector<RenderShapeData> &shapes = scene.getShapes();
+    int width = scene.width();
+    int height = scene.height();
+
+    // history is only meaningful for the same shapes, rendered the same way
+    bool hasHistory = m_valid && width == m_width && height == m_height &&
+                      shapes.size() == m_shapes.size() &&
+                      config.enableDepthOfField == m_config.enableDepthOfField &&
+                      config.enableMotionBlur == m_config.enableMotionBlur &&
+                      config.enableLens == m_config.enableLens && !config.enableLens;
+    for (int i = 0; hasHistory && i < (int)shapes.size(); i++) {
+        hasHistory = shapes[i].primitive.type == m_shapes[i].primitive.type;
+    }
+
+    // the primary hits are recorded while tracing, so finding the surfaces costs no extra rays
+    std::vector<RayTracer::PrimaryHit> hits(width * height);
+    raytracer.setPrimaryHits(hits.data());
+    raytracer.render(imageData, scene, geometry);
+    raytracer.setPrimaryHits(nullptr);
+
+    std::unordered_map<const Shape*, int> shapeIndices;
+    const std::vector<Shape*> &geometryShapes = geometry.getShapes();
+    for (int i = 0; i < (int)geometryShapes.size(); i++) {
+        if (geometryShapes[i] != nullptr) {
+            shapeIndices[geometryShapes[i]] = i;
+        }
+    }
+
+    glm::mat4 inverseView = camera.getInverseViewMatrix();
+    glm::vec3 eyePoint = glm::vec3(inverseView * glm::vec4(0, 0, 0, 1.0f));
+
+    std::vector<glm::mat4> inverseCTMs;
+    for (const RenderShapeData &shape : shapes) {
+        inverseCTMs.push_back(glm::inverse(shape.ctm));
+    }
+
+    std::vector<Surface> surfaces(width * height);
+    std::vector<glm::vec3> radiance(width * height);
+    std::vector<int> historyLength(width * height);
+    int reused = 0;
+
+    for (int r = 0; r < height; r++) {
+        for (int c = 0; c < width; c++) {
+            int index = r * width + c;
+
+            // the direction through the pixel's center, along which the background is reprojected
+            glm::vec3 d = glm::normalize(glm::vec3(inverseView * glm::vec4(scene.getPoint(r, c, camera), 1.0f)) - eyePoint);
+
+            Surface &surface = surfaces[index];
+            const RayTracer::PrimaryHit &hit = hits[index];
+            surface.shape = hit.shape != nullptr ? shapeIndices.at(hit.shape) : -1;
+            surface.distance = surface.shape >= 0 ? glm::length(hit.position - eyePoint) : 0.0f;
+            surface.objectPoint = surface.shape >= 0 ?
+                glm::vec3(inverseCTMs[surface.shape] * glm::vec4(hit.position, 1.0f)) : glm::vec3(0.0f);
+
+            RGBA &pixel = imageData[index];
+            glm::vec3 current = glm::vec3(pixel.r, pixel.g, pixel.b) / 255.0f;
+
+            int previous = hasHistory ? reproject(surface, d) : -1;
+            if (previous < 0) {
+                radiance[index] = current;
+                historyLength[index] = 1;
+                continue;
+            }
+
+            // a running average over the last maxHistory frames
+            historyLength[index] = std::min(m_historyLength[previous] + 1, m_maxHistory);
+            radiance[index] = glm::mix(m_radiance[previous], current, 1.0f / historyLength[index]);
+            reused++;
+
+            glm::vec3 color = glm::clamp(radiance[index], 0.0f, 1.0f);
+            pixel.r = static_cast<std::uint8_t>(color.r * 255.0f);
+            pixel.g = static_cast<std::uint8_t>(color.g * 255.0f);
+            pixel.b = static_cast<std::uint8_t>(color.b * 255.0f);
+        }
+    }
+
+    m_valid = true;
+    m_width = width;
+    m_height = height;
+    m_config = config;
+    m_viewMatrix = camera.getViewMatrix();
+    m_tanX = std::tan(camera.getWidthAngle() / 2.0f);
+    m_tanY = std::tan(camera.getHeightAngle() / 2.0f);
+    m_shapes = shapes;
+    m_surfaces = std::move(surfaces);
+    m_radiance = std::move(radiance);
+    m_historyLength = std::move(historyLength);
+
+    return reused;
+}
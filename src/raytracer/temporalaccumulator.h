@@ -0,0 +1,59 @@
+#pragma once
+
+#include <vector>
+#include "raytracer.h"
+#include "raytracescene.h"
+#include "scenegeometry.h"
+
+// A class accumulating the samples of consecutive frames of a sequence.
+// Each frame is rendered with few samples per pixel. Every pixel's primary hit is then moved back to
+// where its shape and the camera were in the previous frame, and the radiance accumulated there is
+// blended with the new samples. The history is dropped where the previous frame saw a different shape
+// or a surface at a different distance (a disocclusion), and a pixel blends at most maxHistory frames,
+// so lighting changes fade in instead of leaving trails.
+// The output must not depend on how frames are scheduled: an accumulator is only given the frames of one
+// sequence, in order (see BatchRenderer::run).
+
+class TemporalAccumulator
+{
+public:
+    // @param maxHistory The largest number of frames a pixel's accumulated radiance is made of.
+    TemporalAccumulator(int maxHistory = 8);
+
+    void setMaxHistory(int maxHistory);
+
+    // Renders the scene into imageData and blends it with the reprojected previous frames.
+    // @param geometry The shapes of the scene, already updated for this frame.
+    // @return The number of pixels whose history could be reused.
+    int render(RayTracer &raytracer, RGBA *imageData, const RayTraceScene &scene, const SceneGeometry &geometry);
+
+private:
+    // The primary hit of a pixel, recorded while rendering it
+    struct Surface {
+        int shape;            // index of the shape, or -1 on a miss
+        float distance;       // distance from the camera
+        glm::vec3 objectPoint;  // hit point in the shape's object space
+    };
+
+    // Finds where the previous frame saw this pixel's surface.
+    // @return The previous frame's pixel index, or -1 if the surface was not visible there.
+    int reproject(const Surface &surface, const glm::vec3 &direction) const;
+
+    // Projects a point in the previous frame's camera space to a pixel index, or -1 if it is off screen
+    int previousPixel(const glm::vec3 &cameraPoint) const;
+
+    int m_maxHistory;
+
+    // the previous frame
+    bool m_valid = false;
+    int m_width = 0;
+    int m_height = 0;
+    RayTracer::Config m_config;
+    glm::mat4 m_viewMatrix;
+    float m_tanX = 0.0f;
+    float m_tanY = 0.0f;
+    std::vector<RenderShapeData> m_shapes;
+    std::vector<Surface> m_surfaces;
+    std::vector<glm::vec3> m_radiance;
+    std::vector<int> m_historyLength;
+};
@@ -0,0 +1,129 @@
+#include "visibilitycache.h"
+#include "incrementalrenderer.h"
+
+#include <algorithm>
+#include <limits>
+
+// Helper function to check whether two boxes overlap (or touch)
+bool boxesOverlap(const BoundingBox &a, const BoundingBox &b) {
+    return glm::all(glm::lessThanEqual(a.min, b.max)) && glm::all(glm::greaterThanEqual(a.max, b.min));
+}
+
+void VisibilityCache::update(const RayTraceScene &scene, const SceneGeometry &geometry, const std::vector<int> &rebuilt) {
+    const std::vector<Shape*> &shapes = geometry.getShapes();
+    const std::vector<RenderShapeData> &shapeData = scene.getShapes();
+    const std::vector<SceneLightData> &lights = scene.getLights();
+    float globalVel = scene.getGlobalData().globalVel;
+
+    std::vector<bool> isStatic(shapes.size());
+    for (int i = 0; i < (int)shapes.size(); i++) {
+        isStatic[i] = shapes[i] != nullptr;
+    }
+    for (int i : rebuilt) {
+        isStatic[i] = false;
+    }
+
+    m_movingShapes.clear();
+    for (int i = 0; i < (int)shapes.size(); i++) {
+        if (shapes[i] != nullptr && !isStatic[i]) {
+            m_movingShapes.emplace_back(shapes[i], sweptBounds(shapeData[i], globalVel));
+        }
+    }
+
+    bool sameLights = lights.size() == m_lights.size();
+    for (int i = 0; sameLights && i < (int)lights.size(); i++) {
+        sameLights = sameLight(lights[i], m_lights[i]);
+    }
+    // shapes rebuilt by an update the cache did not see are gone, even if they are static again
+    bool sameGeometry = &geometry == m_geometry && geometry.getGeneration() == m_generation + 1;
+    m_geometry = &geometry;
+    m_generation = geometry.getGeneration();
+
+    // a shape that stopped or started moving, or a changed light, changes what every cell holds
+    if (sameGeometry && sameLights && isStatic == m_static) {
+        return;
+    }
+
+    m_static = isStatic;
+    m_lights = lights;
+    m_cells.clear();
+    m_staticShapes.clear();
+
+    glm::vec3 low(std::numeric_limits<float>::max()), high(-std::numeric_limits<float>::max());
+    for (int i = 0; i < (int)shapes.size(); i++) {
+        if (isStatic[i]) {
+            BoundingBox box = sweptBounds(shapeData[i], globalVel);
+            m_staticShapes.emplace_back(shapes[i], box);
+            low = glm::min(low, box.min);
+            high = glm::max(high, box.max);
+        }
+    }
+
+    m_valid = !m_staticShapes.empty();
+    if (!m_valid) {
+        return;
+    }
+
+    // points on the static shapes' surfaces are nudged off them, so the grid reaches a little past them
+    glm::vec3 padding(0.05f);
+    m_gridMin = low - padding;
+    glm::vec3 extent = high - low + 2.0f * padding;
+    m_cellSize = std::max(std::max(extent.x, extent.y), extent.z) / VISIBILITY_GRID_CELLS;
+    m_gridCells = glm::max(glm::ivec3(glm::ceil(extent / m_cellSize)), glm::ivec3(1));
+}
+
+VisibilityCache::Cell VisibilityCache::makeCell(int lightIndex, glm::ivec3 cell) const {
+    const SceneLightData &light = m_lights[lightIndex];
+    glm::vec3 cellMin = m_gridMin + glm::vec3(cell) * m_cellSize;
+    glm::vec3 cellMax = cellMin + glm::vec3(m_cellSize);
+
+    glm::vec3 lightMin, lightMax;
+    if (light.type == LightType::LIGHT_DIRECTIONAL) {
+        // past the grid's far corner there are no static shapes to hit
+        glm::vec3 gridSize = glm::vec3(m_gridCells) * m_cellSize;
+        glm::vec3 toLight = glm::normalize(glm::vec3(-light.dir)) * glm::length(gridSize);
+        lightMin = cellMin + toLight;
+        lightMax = cellMax + toLight;
+    } else {
+        float radius = light.type == LightType::LIGHT_AREA ? 0.5f * std::sqrt(light.width * light.width + light.height * light.height) : 0.0f;
+        lightMin = glm::vec3(light.pos) - glm::vec3(radius);
+        lightMax = glm::vec3(light.pos) + glm::vec3(radius);
+    }
+
+    Cell result{BoundingBox(glm::min(cellMin, lightMin), glm::max(cellMax, lightMax)), {}};
+    for (const auto &[shape, box] : m_staticShapes) {
+        if (boxesOverlap(box, result.region)) {
+            result.occluders.push_back(shape);
+        }
+    }
+    return result;
+}
+
+bool VisibilityCache::occluders(int lightIndex, glm::vec3 point, std::vector<Shape*> &candidates) {
+    if (!m_valid || lightIndex >= (int)m_lights.size()) {
+        return false;
+    }
+
+    glm::ivec3 cell = glm::ivec3(glm::floor((point - m_gridMin) / m_cellSize));
+    if (glm::any(glm::lessThan(cell, glm::ivec3(0))) || glm::any(glm::greaterThanEqual(cell, m_gridCells))) {
+        return false;
+    }
+
+    std::uint64_t key = (static_cast<std::uint64_t>(lightIndex) << 48) |
+                        static_cast<std::uint64_t>((cell.z * m_gridCells.y + cell.y) * m_gridCells.x + cell.x);
+    auto it = m_cells.find(key);
+    if (it == m_cells.end()) {
+        it = m_cells.emplace(key, makeCell(lightIndex, cell)).first;
+    }
+    const Cell &entry = it->second;
+
+    candidates = entry.occluders;
+    // a directional light's region ends at the grid, but moving shapes can be anywhere along the ray
+    bool directional = m_lights[lightIndex].type == LightType::LIGHT_DIRECTIONAL;
+    for (const auto &[shape, box] : m_movingShapes) {
+        if (directional || boxesOverlap(box, entry.region)) {
+            candidates.push_back(shape);
+        }
+    }
+    return true;
+}
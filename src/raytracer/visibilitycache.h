@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "raytracescene.h"
+#include "scenegeometry.h"
+#include "utils/boundingbox.h"
+
+// A cache of which shapes can cast shadows where, kept across the frames of a sequence.
+//
+// Shapes that a frame did not rebuild are static. Space around them is split into a grid, and for
+// each light and cell the cache remembers the static shapes whose bounds reach the region between the
+// cell and the light (the box around both), the only static shapes a shadow ray from the cell to the
+// light can hit. Cells are filled the first time a shadow ray starts in them and kept for as long as
+// the static shapes and the lights stay the same, so a long sequence with a few moving shapes tests
+// each shadow ray against a handful of static shapes and the moving shapes whose swept bounds reach the
+// same region, instead of against every shape. The bounds are conservative, so shadows are unchanged.
+
+const int VISIBILITY_GRID_CELLS = 64; // cells along the longest side of the static shapes' bounds
+
+class VisibilityCache
+{
+public:
+    VisibilityCache() = default;
+
+    // Starts a frame, keeping the cells if the static shapes and the lights are the same as before. The cache
+    // must be updated after every update of geometry, or it starts over, as the update it missed may have
+    // replaced any of the shapes.
+    // @param rebuilt The indices of the shapes this frame's SceneGeometry::update rebuilt, which are moving.
+    void update(const RayTraceScene &scene, const SceneGeometry &geometry, const std::vector<int> &rebuilt);
+
+    // Gathers the shapes a shadow ray from point towards one of the scene's lights could hit.
+    // @return False if point is outside the grid, where every shape has to be tested.
+    bool occluders(int lightIndex, glm::vec3 point, std::vector<Shape*> &candidates);
+
+private:
+    struct Cell {
+        BoundingBox region; // around the cell and the light
+        std::vector<Shape*> occluders;
+    };
+
+    // The region a shadow ray from a cell towards a light stays in, and the static shapes that reach it
+    Cell makeCell(int lightIndex, glm::ivec3 cell) const;
+
+    std::vector<bool> m_static; // of each shape, in the current frame
+    std::vector<SceneLightData> m_lights;
+    const SceneGeometry *m_geometry = nullptr; // the geometry the cells were made for
+    std::uint64_t m_generation = 0;            // and its generation in the current frame
+    std::vector<std::pair<Shape*, BoundingBox>> m_staticShapes;
+    std::vector<std::pair<Shape*, BoundingBox>> m_movingShapes;
+
+    // the grid around the static shapes
+    bool m_valid = false;
+    glm::vec3 m_gridMin = glm::vec3(0.0f);
+    glm::ivec3 m_gridCells = glm::ivec3(0);
+    float m_cellSize = 0.0f;
+
+    std::unordered_map<std::uint64_t, Cell> m_cells; // by light and cell
+};
@@ -0,0 +1,226 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+#include "raytracer/raytracer.h"
+#include "raytracer/raytracescene.h"
+#include "raytracer/scenegeometry.h"
+#include "utils/animation.h"
+#include "utils/sceneparser.h"
+
+// Helper function to parse a scene file, or the middle frame of an animation file
+bool loadScene(const QString &path, RenderData &metaData) {
+    if (!path.endsWith("_animation.json")) {
+        return SceneParser::parseScene(path.toStdString(), metaData);
+    }
+    Animation animation;
+    if (!SceneParser::parseAnimation(path.toStdString(), animation)) {
+        return false;
+    }
+    animation.getFrame((animation.frameCount() + 1) / 2, metaData);
+    return true;
+}
+
+// Helper function to render a scene with fixed seeds.
+// @param seconds Receives the fastest of repeat renders.
+QImage renderScene(const RenderData &metaData, int width, int height, unsigned int seed, int repeat, double &seconds) {
+    // every effect without a sample count of its own; stochastic ones are kept reproducible by the seeds
+    RayTracer::Config config;
+    config.enableShadow = true;
+    config.enableReflection = true;
+    config.enableRefraction = true;
+    config.enableTextureMap = true;
+    config.enableDepthOfField = false;
+    config.enableMotionBlur = false;
+
+    RayTraceScene scene{ width, height, metaData };
+    QImage image(width, height, QImage::Format_RGBX8888);
+    RGBA *data = reinterpret_cast<RGBA *>(image.bits());
+
+    for (int run = 0; run < repeat; run++) {
+        std::srand(seed);
+        Camera::seedRandom(seed);
+
+        auto start = std::chrono::steady_clock::now();
+        SceneGeometry geometry;
+        geometry.update(scene.getShapes());
+        RayTracer raytracer{ config };
+        raytracer.render(data, scene, geometry);
+        double runSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (run == 0 || runSeconds < seconds) {
+            seconds = runSeconds;
+        }
+    }
+    return image;
+}
+
+// Helper function returning the root mean square difference of two images' color channels, from 0 to 255
+double rmse(const QImage &a, const QImage &b) {
+    QImage a8 = a.convertToFormat(QImage::Format_RGBX8888);
+    QImage b8 = b.convertToFormat(QImage::Format_RGBX8888);
+    const RGBA *pa = reinterpret_cast<const RGBA *>(a8.constBits());
+    const RGBA *pb = reinterpret_cast<const RGBA *>(b8.constBits());
+
+    double sum = 0.0;
+    int count = a8.width() * a8.height();
+    for (int i = 0; i < count; i++) {
+        double dr = pa[i].r - pb[i].r;
+        double dg = pa[i].g - pb[i].g;
+        double db = pa[i].b - pb[i].b;
+        sum += dr * dr + dg * dg + db * db;
+    }
+    return std::sqrt(sum / (3.0 * count));
+}
+
+// Renders every scene in scenefiles/ and compares it with the reference image stored in tests/golden/,
+// and with its baseline time in tests/golden/baseline.json if --max-slowdown is given. Run with --update to
+// store new references after an intended change, and with --update-baseline to store new times.
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setApplicationName("projects_ray_golden");
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption rootOption("root", "Repository root the scene files and references are found in.", "path", ".");
+    QCommandLineOption widthOption("width", "Image width.", "pixels", "160");
+    QCommandLineOption heightOption("height", "Image height.", "pixels", "120");
+    QCommandLineOption seedOption("seed", "Seed of the random samples.", "seed", "1230");
+    QCommandLineOption repeatOption("repeat", "Number of times each scene is rendered; the fastest run is timed.", "count", "3");
+    QCommandLineOption toleranceOption("tolerance", "Largest root mean square difference from a reference (0-255).", "rmse", "2.0");
+    QCommandLineOption slowdownOption("max-slowdown", "Also fail renders more than ratio times slower than their baseline time.", "ratio");
+    QCommandLineOption updateOption("update", "Store the renders as the new references.");
+    QCommandLineOption updateBaselineOption("update-baseline", "Store the render times as the new baseline.");
+    parser.addOptions({rootOption, widthOption, heightOption, seedOption, repeatOption, toleranceOption, slowdownOption,
+                       updateOption, updateBaselineOption});
+    parser.process(a);
+
+    QDir root(parser.value(rootOption));
+    int width = parser.value(widthOption).toInt();
+    int height = parser.value(heightOption).toInt();
+    unsigned int seed = parser.value(seedOption).toUInt();
+    int repeat = std::max(parser.value(repeatOption).toInt(), 1);
+    double tolerance = parser.value(toleranceOption).toDouble();
+    bool checkTimes = parser.isSet(slowdownOption);
+    double maxSlowdown = parser.value(slowdownOption).toDouble();
+    bool update = parser.isSet(updateOption);
+    bool updateBaseline = parser.isSet(updateBaselineOption);
+
+    QDir sceneDir(root.filePath("scenefiles"));
+    QDir goldenDir(root.filePath("tests/golden"));
+    QString baselinePath = goldenDir.filePath("baseline.json");
+
+    // the committed times are generous, as they have to hold on any machine and in unoptimized builds
+    QJsonObject baseline;
+    QFile baselineFile(baselinePath);
+    if (checkTimes) {
+        if (!baselineFile.open(QIODevice::ReadOnly)) {
+            std::cerr << "Error: --max-slowdown needs the times in \"" << baselinePath.toStdString() << "\"" << std::endl;
+            return 1;
+        }
+        baseline = QJsonDocument::fromJson(baselineFile.readAll()).object();
+        baselineFile.close();
+    }
+
+    QStringList scenes = sceneDir.entryList(QStringList{"*.json"}, QDir::Files, QDir::Name);
+    if (scenes.isEmpty()) {
+        std::cerr << "Error: no scene files in \"" << sceneDir.path().toStdString() << "\"" << std::endl;
+        return 1;
+    }
+
+    int failures = 0;
+    QJsonObject newBaseline;
+    for (const QString &sceneName : scenes) {
+        QString name = QFileInfo(sceneName).completeBaseName();
+
+        RenderData metaData;
+        if (!loadScene(sceneDir.filePath(sceneName), metaData)) {
+            std::cerr << "FAIL " << name.toStdString() << ": could not load the scene" << std::endl;
+            failures++;
+            continue;
+        }
+
+        double seconds = 0.0;
+        QImage image = renderScene(metaData, width, height, seed, repeat, seconds);
+        QString referencePath = goldenDir.filePath(name + ".png");
+
+        if (update || updateBaseline) {
+            if (update && (!goldenDir.mkpath(".") || !image.save(referencePath, "PNG"))) {
+                std::cerr << "Error: could not write \"" << referencePath.toStdString() << "\"" << std::endl;
+                return 1;
+            }
+            newBaseline[name] = seconds;
+            std::cout << "Updated " << name.toStdString() << " (" << seconds << " s)" << std::endl;
+            continue;
+        }
+
+        QImage reference(referencePath);
+        if (reference.isNull()) {
+            std::cerr << "FAIL " << name.toStdString() << ": no reference image; run projects_ray_golden --update "
+                      << "to store it" << std::endl;
+            failures++;
+            continue;
+        }
+
+        bool passed = true;
+        if (reference.size() != image.size()) {
+            std::cerr << "FAIL " << name.toStdString() << ": the reference is " << reference.width() << "x"
+                      << reference.height() << ", rendered " << width << "x" << height << std::endl;
+            failures++;
+            continue;
+        }
+
+        double difference = rmse(image, reference);
+        if (difference > tolerance) {
+            std::cerr << "FAIL " << name.toStdString() << ": RMSE " << difference << " above " << tolerance << std::endl;
+            image.save(goldenDir.filePath(name + ".actual.png"), "PNG");
+            passed = false;
+        }
+
+        if (checkTimes && !baseline.contains(name)) {
+            std::cerr << "FAIL " << name.toStdString() << ": no baseline time; run projects_ray_golden --update-baseline "
+                      << "to store it" << std::endl;
+            passed = false;
+        } else if (checkTimes) {
+            double baselineSeconds = baseline[name].toDouble();
+            if (seconds > maxSlowdown * baselineSeconds) {
+                std::cerr << "FAIL " << name.toStdString() << ": " << seconds << " s is more than " << maxSlowdown
+                          << " times the baseline of " << baselineSeconds << " s" << std::endl;
+                passed = false;
+            }
+        }
+
+        if (passed) {
+            std::cout << "PASS " << name.toStdString() << ": RMSE " << difference << ", " << seconds << " s" << std::endl;
+        } else {
+            failures++;
+        }
+    }
+
+    if (updateBaseline) {
+        QFile file(baselinePath);
+        if (!file.open(QIODevice::WriteOnly)) {
+            std::cerr << "Error: could not write \"" << baselinePath.toStdString() << "\"" << std::endl;
+            return 1;
+        }
+        file.write(QJsonDocument(newBaseline).toJson());
+    }
+    if (update || updateBaseline) {
+        return 0;
+    }
+
+    if (failures > 0) {
+        std::cerr << failures << " of " << scenes.size() << " scenes failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,270 @@
+#include "animation.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <glm/gtx/transform.hpp>
+
+// channels of the globalData object and the fields they set
+const std::vector<std::string> GLOBAL_CHANNELS = {"ambientCoeff", "diffuseCoeff", "specularCoeff", "transparentCoeff", "globalVel"};
+
+// channels of the cameraData object and the number of values each takes
+const std::vector<std::pair<std::string, int>> CAMERA_CHANNELS = {
+    {"position", 3}, {"up", 3}, {"look", 3}, {"focus", 3}, {"heightAngle", 1}, {"aperture", 1}, {"focalLength", 1}
+};
+
+bool Animation::readJSON(const std::string &filepath) {
+    QFile file(filepath.c_str());
+    if (!file.open(QFile::ReadOnly)) {
+        std::cout << "could not open " << filepath << std::endl;
+        return false;
+    }
+
+    QJsonParseError jsonError;
+    QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &jsonError);
+    file.close();
+    if (doc.isNull()) {
+        std::cout << "could not parse " << filepath << std::endl;
+        std::cout << "parse error at line " << jsonError.offset << ": "
+                  << jsonError.errorString().toStdString() << std::endl;
+        return false;
+    }
+    if (!doc.isObject()) {
+        std::cout << "animation document is not an object" << std::endl;
+        return false;
+    }
+
+    QJsonObject animation = doc.object();
+    if (!animation["base"].isString()) {
+        std::cout << "animation must contain string field \"base\"" << std::endl;
+        return false;
+    }
+    if (!animation["frames"].isDouble() || animation["frames"].toInt() < 1) {
+        std::cout << "animation must contain a positive \"frames\" count" << std::endl;
+        return false;
+    }
+    m_frames = animation["frames"].toInt();
+
+    // the base scene is parsed once and every frame is derived from it
+    std::filesystem::path basePath = std::filesystem::path(filepath).parent_path() /
+                                     animation["base"].toString().toStdString();
+    if (!SceneParser::parseScene(basePath.string(), m_base)) {
+        std::cout << "could not parse base scene " << basePath.string() << std::endl;
+        return false;
+    }
+
+    m_tracks.clear();
+    if (animation.contains("keyframes")) {
+        if (!animation["keyframes"].isArray()) {
+            std::cout << "animation keyframes must be of type array" << std::endl;
+            return false;
+        }
+        for (const QJsonValue &keyframe : animation["keyframes"].toArray()) {
+            if (!keyframe.isObject() || !parseKeyframe(keyframe.toObject())) {
+                std::cout << "could not parse keyframe in " << filepath << std::endl;
+                return false;
+            }
+        }
+    }
+
+    for (auto &[channel, keys] : m_tracks) {
+        std::stable_sort(keys.begin(), keys.end(), [](const Key &a, const Key &b) { return a.frame < b.frame; });
+    }
+
+    return true;
+}
+
+bool Animation::parseKeyframe(const QJsonObject &keyframe) {
+    if (!keyframe["frame"].isDouble()) {
+        std::cout << "keyframe must contain a \"frame\" number" << std::endl;
+        return false;
+    }
+    int frame = keyframe["frame"].toInt();
+
+    bool step = false;
+    if (keyframe.contains("interpolation")) {
+        QString interpolation = keyframe["interpolation"].toString();
+        if (interpolation != "linear" && interpolation != "step") {
+            std::cout << "keyframe interpolation must be \"linear\" or \"step\"" << std::endl;
+            return false;
+        }
+        step = interpolation == "step";
+    }
+
+    if (keyframe.contains("globalData")) {
+        QJsonObject globalData = keyframe["globalData"].toObject();
+        for (const std::string &channel : GLOBAL_CHANNELS) {
+            if (globalData.contains(QString::fromStdString(channel)) &&
+                !addKey("globalData." + channel, globalData[QString::fromStdString(channel)], 1, frame, step)) {
+                return false;
+            }
+        }
+    }
+
+    if (keyframe.contains("cameraData")) {
+        QJsonObject cameraData = keyframe["cameraData"].toObject();
+        if (cameraData.contains("look") && cameraData.contains("focus")) {
+            std::cout << "keyframe cameraData cannot contain both \"look\" and \"focus\"" << std::endl;
+            return false;
+        }
+        for (const auto &[channel, size] : CAMERA_CHANNELS) {
+            if (cameraData.contains(QString::fromStdString(channel)) &&
+                !addKey("cameraData." + channel, cameraData[QString::fromStdString(channel)], size, frame, step)) {
+                return false;
+            }
+        }
+    }
+
+    return parseObjectDeltas(keyframe, "shapes", m_base.shapes.size(), frame, step) &&
+           parseObjectDeltas(keyframe, "lights", m_base.lights.size(), frame, step);
+}
+
+bool Animation::parseObjectDeltas(const QJsonObject &keyframe, const std::string &field, int count, int frame, bool step) {
+    QString key = QString::fromStdString(field);
+    if (!keyframe.contains(key)) {
+        return true;
+    }
+    if (!keyframe[key].isArray()) {
+        std::cout << "keyframe " << field << " must be of type array" << std::endl;
+        return false;
+    }
+
+    for (const QJsonValue &value : keyframe[key].toArray()) {
+        QJsonObject delta = value.toObject();
+        int index = delta["index"].toInt(-1);
+        if (index < 0 || index >= count) {
+            std::cout << "keyframe " << field << " entry has no valid \"index\"" << std::endl;
+            return false;
+        }
+
+        std::string prefix = field + "." + std::to_string(index) + ".";
+        if ((delta.contains("translate") && !addKey(prefix + "translate", delta["translate"], 3, frame, step)) ||
+            (delta.contains("rotate") && !addKey(prefix + "rotate", delta["rotate"], 4, frame, step)) ||
+            (delta.contains("scale") && !addKey(prefix + "scale", delta["scale"], 3, frame, step)) ||
+            (delta.contains("color") && !addKey(prefix + "color", delta["color"], 3, frame, step))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Animation::addKey(const std::string &channel, const QJsonValue &value, int size, int frame, bool step) {
+    glm::vec4 parsed(0.0f);
+
+    if (size == 1 && value.isDouble()) {
+        parsed.x = value.toDouble();
+    }
+    else if (value.isArray() && value.toArray().size() == size) {
+        QJsonArray array = value.toArray();
+        for (int i = 0; i < size; i++) {
+            if (!array[i].isDouble()) {
+                std::cout << "keyframe " << channel << " must contain floating-point values" << std::endl;
+                return false;
+            }
+            parsed[i] = array[i].toDouble();
+        }
+    }
+    else {
+        std::cout << "keyframe " << channel << " must have " << size << " floating-point value(s)" << std::endl;
+        return false;
+    }
+
+    m_tracks[channel].push_back(Key{frame, parsed, step});
+    return true;
+}
+
+int Animation::frameCount() const {
+    return m_frames;
+}
+
+bool Animation::evaluate(const std::string &channel, int frame, glm::vec4 &value) const {
+    auto track = m_tracks.find(channel);
+    if (track == m_tracks.end()) {
+        return false;
+    }
+    const std::vector<Key> &keys = track->second;
+
+    // the first key after this frame, and the one before it
+    auto next = std::upper_bound(keys.begin(), keys.end(), frame,
+                                 [](int f, const Key &key) { return f < key.frame; });
+    if (next == keys.begin()) {
+        return false;
+    }
+    const Key &previous = *(next - 1);
+
+    if (next == keys.end() || previous.step) {
+        value = previous.value;
+    } else {
+        float t = static_cast<float>(frame - previous.frame) / (next->frame - previous.frame);
+        value = glm::mix(previous.value, next->value, t);
+    }
+    return true;
+}
+
+// Helper function to build the world-space delta transform of an animated shape or light
+glm::mat4 deltaTransform(const glm::vec4 &translate, const glm::vec4 &rotate, const glm::vec4 &scale) {
+    glm::mat4 delta = glm::translate(glm::vec3(translate));
+    if (rotate.w != 0.0f && glm::length(glm::vec3(rotate)) > 0.0f) {
+        delta = delta * glm::rotate(glm::radians(rotate.w), glm::normalize(glm::vec3(rotate)));
+    }
+    return delta * glm::scale(glm::vec3(scale));
+}
+
+void Animation::getFrame(int frame, RenderData &renderData) const {
+    renderData = m_base;
+    glm::vec4 value;
+
+    SceneGlobalData &global = renderData.globalData;
+    float *globalFields[] = {&global.ka, &global.kd, &global.ks, &global.kt, &global.globalVel};
+    for (int i = 0; i < (int)GLOBAL_CHANNELS.size(); i++) {
+        if (evaluate("globalData." + GLOBAL_CHANNELS[i], frame, value)) {
+            *globalFields[i] = value.x;
+        }
+    }
+
+    SceneCameraData &camera = renderData.cameraData;
+    if (evaluate("cameraData.position", frame, value)) camera.pos = glm::vec4(glm::vec3(value), 1.0f);
+    if (evaluate("cameraData.up", frame, value)) camera.up = glm::vec4(glm::vec3(value), 0.0f);
+    if (evaluate("cameraData.look", frame, value)) camera.look = glm::vec4(glm::vec3(value), 0.0f);
+    if (evaluate("cameraData.focus", frame, value)) camera.look = glm::vec4(glm::vec3(value) - glm::vec3(camera.pos), 0.0f);
+    if (evaluate("cameraData.heightAngle", frame, value)) camera.heightAngle = glm::radians(value.x);
+    if (evaluate("cameraData.aperture", frame, value)) camera.aperture = value.x;
+    if (evaluate("cameraData.focalLength", frame, value)) camera.focalLength = value.x;
+
+    for (int i = 0; i < (int)renderData.shapes.size(); i++) {
+        std::string prefix = "shapes." + std::to_string(i) + ".";
+        glm::vec4 translate(0.0f), rotate(0.0f), scale(1.0f);
+        bool animated = evaluate(prefix + "translate", frame, translate);
+        animated = evaluate(prefix + "rotate", frame, rotate) || animated;
+        animated = evaluate(prefix + "scale", frame, scale) || animated;
+
+        if (animated) {
+            renderData.shapes[i].ctm = deltaTransform(translate, rotate, scale) * renderData.shapes[i].ctm;
+        }
+    }
+
+    for (int i = 0; i < (int)renderData.lights.size(); i++) {
+        std::string prefix = "lights." + std::to_string(i) + ".";
+        SceneLightData &light = renderData.lights[i];
+
+        glm::vec4 translate(0.0f), rotate(0.0f), scale(1.0f);
+        bool animated = evaluate(prefix + "translate", frame, translate);
+        animated = evaluate(prefix + "rotate", frame, rotate) || animated;
+
+        if (animated) {
+            glm::mat4 delta = deltaTransform(translate, rotate, scale);
+            if (light.type != LightType::LIGHT_DIRECTIONAL) {
+                light.pos = delta * light.pos;
+            }
+            if (light.type != LightType::LIGHT_POINT) {
+                light.dir = glm::normalize(delta * light.dir);
+            }
+        }
+        if (evaluate(prefix + "color", frame, value)) {
+            light.color = glm::vec4(glm::vec3(value), light.color.a);
+        }
+    }
+}
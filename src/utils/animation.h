@@ -0,0 +1,66 @@
+#pragma once
+
+#include "sceneparser.h"
+#include <map>
+#include <string>
+#include <vector>
+
+#include <QJsonObject>
+
+// A class representing an animated scene: one base scene file plus keyframes that change
+// global coefficients, the camera, and the transforms of individual shapes and lights.
+//
+// Every keyframe sets some channels (e.g. the camera's focal length, or the translation of
+// shape 3) at one frame. Between two keyframes that set the same channel the value is
+// interpolated linearly, or held if the first keyframe's "interpolation" is "step".
+// Before a channel's first keyframe the base scene's value is used.
+//
+// Example:
+// {
+//   "base": "falling_spheres.json",
+//   "frames": 101,
+//   "keyframes": [
+//     { "frame": 1,   "globalData": { "globalVel": 0.0 } },
+//     { "frame": 101, "globalData": { "globalVel": 3.0 },
+//                     "shapes": [ { "index": 2, "translate": [0, -1, 0] } ] }
+//   ]
+// }
+//
+// Shape and light transforms are deltas in world space, applied on top of the base scene's
+// transforms as translate * rotate * scale. Rotations are [x, y, z, angle in degrees].
+// Shapes and lights are indexed in the order the base scene lists them.
+
+class Animation
+{
+public:
+    // Parse the animation file and the base scene it names. The base scene's path is
+    // relative to the animation file.
+    // @return A boolean value indicating whether both files could be parsed.
+    bool readJSON(const std::string &filepath);
+
+    // The number of frames; frames are numbered from 1.
+    int frameCount() const;
+
+    // Fills renderData with the scene as it is at the given frame.
+    void getFrame(int frame, RenderData &renderData) const;
+
+private:
+    struct Key {
+        int frame;
+        glm::vec4 value;
+        bool step;
+    };
+
+    bool parseKeyframe(const QJsonObject &keyframe);
+    bool parseObjectDeltas(const QJsonObject &keyframe, const std::string &field, int count, int frame, bool step);
+    bool addKey(const std::string &channel, const QJsonValue &value, int size, int frame, bool step);
+
+    // Returns the channel's value at frame, or false if the channel is not animated yet
+    bool evaluate(const std::string &channel, int frame, glm::vec4 &value) const;
+
+    RenderData m_base;
+    int m_frames = 0;
+
+    // channel name -> keys sorted by frame
+    std::map<std::string, std::vector<Key>> m_tracks;
+};
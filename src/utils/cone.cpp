@@ -1,4 +1,6 @@
 #include "cone.h"
+#include "texturesampler.h"
+#include "renderstats.h"
 #include <iostream>
 
 Cone::Cone(const glm::mat4& ctm, const SceneMaterial& material, glm::vec3 velocity, const Image* image)
@@ -24,6 +26,7 @@ glm::vec3 Cone::calcNormal(const glm::vec3 point) {
 
 // Method to calculate the intersection with a ray
 bool Cone::calcIntersection(const glm::vec3 rayOrigin, const glm::vec3 rayDirection, glm::vec3& intersectionPoint, float& t, float time, float vel) {
+    RT_STAT_INC(ConeTests);
     glm::vec3 P = glm::vec3(m_inverseCTM * glm::vec4(rayOrigin, 1.0f));
     glm::vec3 d = glm::normalize(glm::vec3(m_inverseCTM * glm::vec4(rayDirection, 0.0f)));
 
@@ -119,7 +122,7 @@ double Cone::surfaceArea() {
     return M_PI * m_radius * (m_radius + slantHeight);
 }
 
-glm::vec3 Cone::getTexture(const glm::vec3& intersection) {
+glm::vec3 Cone::getTexture(const glm::vec3& intersection, float footprint) {
     if (m_image == nullptr){
         return glm::vec3(0, 0, 0);
     }
@@ -136,15 +139,9 @@ glm::vec3 Cone::getTexture(const glm::vec3& intersection) {
         v = objInt.y + 0.5f;
     }
 
-    int x = static_cast<int>(std::floor(u * m_material.textureMap.repeatU * m_image->width)) % m_image->width;
-    int y = static_cast<int>(std::floor((1 - v) * m_material.textureMap.repeatV * m_image->height)) % m_image->height;
-
-    if (u == 1.0f) x = m_material.textureMap.repeatU * m_image->width - 1;
-    if (v == 0.0f) y = m_material.textureMap.repeatV * m_image->height - 1;
-
-    RGBA pixel = m_image->data[y * m_image->width + x];
-
-    return glm::vec3(pixel.r / 255.0f, pixel.g / 255.0f, pixel.b / 255.0f);
+    // the footprint in (u, v), which spans about one unit of object space
+    float uvFootprint = footprint / m_scale;
+    return sampleTexture(*m_image, m_material.textureMap, u, v, uvFootprint);
 }
 
 void Cone::id() {
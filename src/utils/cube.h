@@ -17,7 +17,7 @@ public:
 
     double surfaceArea() override;
 
-    glm::vec3 getTexture(const glm::vec3& intersection) override;
+    glm::vec3 getTexture(const glm::vec3& intersection, float footprint = 0.0f) override;
 
     void id() override;
 
@@ -1,4 +1,6 @@
 #include "cylinder.h"
+#include "texturesampler.h"
+#include "renderstats.h"
 #include "imagereader.h"
 #include <iostream>
 
@@ -26,6 +28,7 @@ glm::vec3 Cylinder::calcNormal(const glm::vec3 point) {
 
 
 bool Cylinder::calcIntersection(const glm::vec3 rayOrigin, const glm::vec3 rayDirection, glm::vec3& intersectionPoint, float &t, float time, float vel) {
+    RT_STAT_INC(CylinderTests);
     glm::vec3 P = glm::vec3(m_inverseCTM * glm::vec4(rayOrigin, 1.0f));
     glm::vec3 d = glm::normalize(glm::vec3(m_inverseCTM * glm::vec4(rayDirection, 0.0f)));
 
@@ -115,7 +118,7 @@ double Cylinder::surfaceArea() {
     return 2.0 * M_PI * m_radius * (m_radius + m_height);
 }
 
-glm::vec3 Cylinder::getTexture(const glm::vec3& intersection) {
+glm::vec3 Cylinder::getTexture(const glm::vec3& intersection, float footprint) {
     if (m_image == nullptr){
         return glm::vec3(0, 0, 0);
     }
@@ -137,14 +140,9 @@ glm::vec3 Cylinder::getTexture(const glm::vec3& intersection) {
         u = theta >= 0 ? 1.f - (theta / (2.f * M_PI)) : -theta / (2.f * M_PI);
     }
 
-    int x = static_cast<int>(std::floor(u * m_material.textureMap.repeatU * m_image->width)) % m_image->width;
-    int y = static_cast<int>(std::floor((1 - v) * m_material.textureMap.repeatV * m_image->height)) % m_image->height;
-
-    if (u == 1.0f) x = m_material.textureMap.repeatU * m_image->width - 1;
-    if (v == 0.0f) y = m_material.textureMap.repeatV * m_image->height - 1;
-
-    RGBA pixel = m_image->data[y * m_image->width + x];
-    return glm::vec3(pixel.r / 255.0f, pixel.g / 255.0f, pixel.b / 255.0f);
+    // the footprint in (u, v), which spans about one unit of object space
+    float uvFootprint = footprint / m_scale;
+    return sampleTexture(*m_image, m_material.textureMap, u, v, uvFootprint);
 }
 
 
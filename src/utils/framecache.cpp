@@ -0,0 +1,91 @@
+#include "framecache.h"
+
+#include <QMutexLocker>
+#include <iostream>
+
+FrameCache::FrameCache(qint64 maxBytes)
+    : m_cache(maxBytes / 1024)
+{
+    // a single worker keeps prefetching from competing with the GUI thread for cores
+    m_pool.setMaxThreadCount(1);
+}
+
+FrameCache::~FrameCache() {
+    {
+        QMutexLocker locker(&m_mutex);
+        m_generation++;
+    }
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+QImage FrameCache::get(const QString &filePath) {
+    {
+        QMutexLocker locker(&m_mutex);
+        if (QImage *frame = m_cache.object(filePath)) {
+            return *frame;
+        }
+    }
+
+    QImage frame = decode(filePath);
+    if (frame.isNull()) {
+        std::cout << "Failed to load image: " << filePath.toStdString() << std::endl;
+        return frame;
+    }
+
+    insert(filePath, frame);
+    return frame;
+}
+
+void FrameCache::prefetch(const QStringList &filePaths) {
+    QMutexLocker locker(&m_mutex);
+    int generation = ++m_generation;
+
+    for (const QString &filePath : filePaths) {
+        if (m_cache.contains(filePath)) {
+            continue;
+        }
+
+        // frames still queued from an earlier request are kept by marking them as current
+        bool queued = m_pending.contains(filePath);
+        m_pending[filePath] = generation;
+        if (queued) {
+            continue;
+        }
+
+        m_pool.start([this, filePath]() {
+            {
+                // drop frames that a newer prefetch request no longer asks for
+                QMutexLocker locker(&m_mutex);
+                if (m_pending.value(filePath) != m_generation) {
+                    m_pending.remove(filePath);
+                    return;
+                }
+            }
+
+            QImage frame = decode(filePath);
+            if (!frame.isNull()) {
+                insert(filePath, frame);
+            }
+
+            QMutexLocker locker(&m_mutex);
+            m_pending.remove(filePath);
+        });
+    }
+}
+
+QImage FrameCache::decode(const QString &filePath) {
+    QImage frame;
+    if (!frame.load(filePath)) {
+        return QImage();
+    }
+
+    // RGB32 is the raster paint engine's native format, so QPixmap::fromImage does not convert
+    return frame.convertToFormat(QImage::Format_RGB32);
+}
+
+void FrameCache::insert(const QString &filePath, const QImage &frame) {
+    QMutexLocker locker(&m_mutex);
+    int cost = static_cast<int>(frame.sizeInBytes() / 1024);
+    m_cache.insert(filePath, new QImage(frame), cost);
+}
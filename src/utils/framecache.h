@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+
+// An in-memory LRU cache of decoded frames for the pre-rendered slider sequences.
+// Frames are keyed by file path and stored as QImages in a pixmap-ready format, so the
+// GUI thread only has to wrap them in a QPixmap. Neighboring frames can be decoded ahead
+// of time on a background thread.
+
+class FrameCache
+{
+public:
+    // @param maxBytes The memory cap for all cached frames, in bytes.
+    FrameCache(qint64 maxBytes = 512ll * 1024 * 1024);
+    ~FrameCache();
+
+    // Returns the decoded frame, loading it synchronously on a miss.
+    // Returns a null QImage if the file could not be loaded.
+    QImage get(const QString &filePath);
+
+    // Queues the given frames to be decoded on the background thread, nearest first.
+    // Frames that are already cached are skipped, and queued frames from an earlier call
+    // that are not in this list are dropped before they are decoded.
+    void prefetch(const QStringList &filePaths);
+
+private:
+    static QImage decode(const QString &filePath);
+    void insert(const QString &filePath, const QImage &frame);
+
+    QCache<QString, QImage> m_cache; // cost is measured in KB
+    QHash<QString, int> m_pending; // queued frames and the request that last asked for them
+    QMutex m_mutex;
+    int m_generation = 0;
+
+    QThreadPool m_pool;
+};
@@ -1,31 +1,25 @@
 #include "imagereader.h"
+#include "texturesampler.h"
 
 /**
- * @brief Stores the image specified from the input file in this class's
- * `std::vector<RGBA> m_image`.
+ * @brief Decodes the image file into the tiled texel layout and builds its mip chain.
+ * RGBX8888 rows are exactly width * 4 bytes, the same layout as an array of RGBA, so the
+ * decoded rows are tiled straight from the QImage's buffer, which is freed afterwards.
  * @param file: file path to an image
- * @return True if successfully loads image, False otherwise.
+ * @return The image, or nullptr if it could not be loaded.
  */
 Image* loadImageFromFile(std::string file) {
     QImage myQImage;
 
-    int width; int height;
     if (!myQImage.load(QString::fromStdString(file))) {
         std::cout<<"Failed to load in image: " << file << std::endl;
         return nullptr;
     }
-    myQImage = myQImage.convertToFormat(QImage::Format_RGBX8888);
-    width = myQImage.width();
-    height = myQImage.height();
+    // converts in place where the formats allow it, and not at all if the file was already RGBX
+    myQImage = std::move(myQImage).convertToFormat(QImage::Format_RGBX8888);
 
-    RGBA* data = new RGBA[width*height];
-    QByteArray arr = QByteArray::fromRawData((const char*) myQImage.bits(), myQImage.sizeInBytes());
-
-    for (int i = 0; i < arr.size() / 4.f; i++){
-        data[i] = RGBA{(std::uint8_t) arr[4*i], (std::uint8_t) arr[4*i+1], (std::uint8_t) arr[4*i+2], (std::uint8_t) arr[4*i+3]};
-    }
-
-    Image* myImage = new Image{data, width, height};
+    Image* myImage = new Image{myQImage.width(), myQImage.height(), {}};
+    buildMipChain(*myImage, reinterpret_cast<const RGBA*>(myQImage.constBits()));
 
     return myImage;
 }
@@ -4,11 +4,59 @@
 #include <QString>
 #include <QImage>
 #include <iostream>
+#include <memory>
+#include <vector>
+
+class TexturePages;
+
+// One level of an image's mip chain.
+// Texels are stored in 8x8 tiles, row by row within a tile and tile by tile across the level, so
+// the texels around a lookup (and the four a bilinear filter reads) usually share a cache line or two
+// instead of being a whole image row apart.
+struct MipLevel {
+    int width;
+    int height;
+    int tilesX; // tiles per row of tiles
+    std::vector<RGBA> texels;
+
+    // The level's texels in a compressed image's format instead, in the same tile order
+    std::vector<std::uint64_t> blocks;
+    std::vector<std::uint8_t> indices;
+
+    // The index of texel (x, y) in texels
+    int index(int x, int y) const {
+        return (((y >> 3) * tilesX + (x >> 3)) << 6) + ((y & 7) << 3) + (x & 7);
+    }
+
+    RGBA& texel(int x, int y) { return texels[index(x, y)]; }
+    const RGBA& texel(int x, int y) const { return texels[index(x, y)]; }
+};
+
+// How an image's levels store their texels
+enum class TextureFormat {
+    RGBA8,    // MipLevel::texels
+    BC1,      // MipLevel::blocks (see texturecompression.h)
+    Palette8, // MipLevel::indices into Image::palette
+};
 
 struct Image {
-    RGBA* data;
     int width;
     int height;
+
+    // The mip chain (see buildMipChain): levels[0] is the image itself, each next level half the size
+    std::vector<MipLevel> levels;
+
+    // Set for a streamed texture (see texturepager.h), whose levels have no texels of their own
+    std::shared_ptr<const TexturePages> pages;
+
+    // Set for a texture packed into an atlas (see textureatlas.h), whose levels have no texels of their own:
+    // they are the atlas's, starting at (atlasX, atlasY) >> level
+    std::shared_ptr<const Image> atlas;
+    int atlasX = 0;
+    int atlasY = 0;
+
+    TextureFormat format = TextureFormat::RGBA8;
+    std::vector<RGBA> palette; // of a Palette8 image
 };
 
 Image* loadImageFromFile(std::string file);
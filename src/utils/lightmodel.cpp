@@ -1,63 +1,62 @@
 #include "lightmodel.h"
 
-glm::vec4 phong(const RayTraceScene &scene,
-           glm::vec3 position,
-           glm::vec3 normal,
-           glm::vec3 directionToCamera,
-           SceneMaterial material,
-           SceneLightData light,
-           glm::vec3 texture) {
-    glm::vec4 illumination(0, 0, 0, 1);
-    if (light.type == LightType::LIGHT_AREA) {
-        const int numSamples = 8;
-        glm::vec4 totalIllumination(0, 0, 0, 1);
-
-        glm::vec3 lightNormal = glm::normalize(glm::vec3(light.dir));
-
-        glm::vec3 upVector = (std::abs(glm::dot(lightNormal, glm::vec3(0, 1, 0))) > 0.9f) ?
-                                 glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0);
-
-        glm::vec3 lightU = glm::normalize(glm::cross(lightNormal, upVector));
-        glm::vec3 lightV = glm::normalize(glm::cross(lightU, lightNormal));
-
-        for (int i = 0; i < numSamples; i++) {
-            float u = light.width * (static_cast<float>(rand()) / RAND_MAX - 0.5f);
-            float v = light.height * (static_cast<float>(rand()) / RAND_MAX - 0.5f);
+#include <limits>
 
-            glm::vec3 samplePos = glm::vec3(light.pos) + (u * lightU) + (v * lightV);
-
-            glm::vec3 directionToLight = samplePos - position;
-            float distance = glm::length(directionToLight);
-            glm::vec3 normalizedDirToLight = glm::normalize(directionToLight);
+float lightInfluenceRadius(const SceneLightData &light) {
+    if (light.type == LightType::LIGHT_DIRECTIONAL) {
+        return std::numeric_limits<float>::infinity();
+    }
 
-            float sampleAttenuation = 1.0f / (light.function.x +
-                                              light.function.y * distance +
-                                              light.function.z * distance * distance);
-            sampleAttenuation = glm::min(sampleAttenuation, 1.0f);
+    float brightest = std::max(light.color.r, std::max(light.color.g, light.color.b));
+    if (brightest <= 0.0f) {
+        return 0.0f;
+    }
 
-            float dotProduct = glm::dot(normal, normalizedDirToLight);
-            if (dotProduct > 0) {
-                glm::vec4 diffuseBlend = glm::mix(material.cDiffuse * scene.getGlobalData().kd,
-                                                  glm::vec4(texture, 0.0f),
-                                                  material.blend);
+    // the distance where function.x + function.y * d + function.z * d^2 reaches brightest / LIGHT_CUTOFF
+    float target = brightest / LIGHT_CUTOFF;
+    const glm::vec3 &f = light.function;
+    float radius;
+    if (f.z > 0.0f) {
+        float discriminant = f.y * f.y + 4.0f * f.z * (target - f.x);
+        radius = discriminant > 0.0f ? std::max((-f.y + std::sqrt(discriminant)) / (2.0f * f.z), 0.0f) : 0.0f;
+    } else if (f.y > 0.0f) {
+        radius = std::max(target - f.x, 0.0f) / f.y;
+    } else {
+        radius = f.x < target ? std::numeric_limits<float>::infinity() : 0.0f;
+    }
 
-                totalIllumination += diffuseBlend * dotProduct * light.color * sampleAttenuation;
+    if (light.type == LightType::LIGHT_AREA) {
+        radius += 0.5f * std::sqrt(light.width * light.width + light.height * light.height);
+    }
+    return radius;
+}
 
-                glm::vec3 reflection = glm::reflect(normalizedDirToLight, normal);
-                float specAngle = glm::dot(glm::normalize(-reflection), directionToCamera);
-                if (specAngle > 0) {
-                    float specFactor = glm::pow(specAngle, material.shininess);
-                    glm::vec3 specular = material.cSpecular * scene.getGlobalData().ks *
-                                         specFactor * light.color * sampleAttenuation;
-                    totalIllumination += glm::vec4(specular, 0.0f);
-                }
-            }
-        }
+bool lightReaches(const SceneLightData &light, float radius, glm::vec3 point) {
+    if (light.type == LightType::LIGHT_DIRECTIONAL) {
+        return true;
+    }
 
-        illumination += totalIllumination / float(numSamples);
-        return illumination;
+    glm::vec3 fromLight = point - glm::vec3(light.pos);
+    float distance = glm::length(fromLight);
+    if (distance > radius) {
+        return false;
+    }
+    // phong gives no light at or past the cone's edge
+    if (light.type == LightType::LIGHT_SPOT && distance > 0.0f &&
+        glm::dot(fromLight / distance, glm::normalize(glm::vec3(light.dir))) <= glm::cos(light.angle)) {
+        return false;
     }
+    return true;
+}
 
+glm::vec4 phong(const RayTraceScene &scene,
+           glm::vec3 position,
+           glm::vec3 normal,
+           glm::vec3 directionToCamera,
+           const SceneMaterial &material,
+           const SceneLightData &light,
+           glm::vec3 texture) {
+    glm::vec4 illumination(0, 0, 0, 1);
     float attenuation = 1.0f;
     glm::vec3 lightDirection;
     float intensity = 1.0f;
@@ -94,8 +93,11 @@ glm::vec4 phong(const RayTraceScene &scene,
         lightDirection = glm::normalize(glm::vec3(-light.dir));
     }
 
+    // a light behind the surface adds no specular either, as in phongSample and the light tree's importance
     float dotProduct = glm::dot(normal, lightDirection);
-    dotProduct = dotProduct > 0 ? dotProduct : 0;
+    if (dotProduct <= 0) {
+        return illumination;
+    }
     glm::vec4 diffuseBlend = glm::mix(material.cDiffuse * scene.getGlobalData().kd, glm::vec4(texture, 0.0f), material.blend);
     glm::vec4 diffuse = diffuseBlend * dotProduct * intensity * light.color * attenuation;
     illumination += diffuse;
@@ -111,3 +113,33 @@ glm::vec4 phong(const RayTraceScene &scene,
     return illumination;
 }
 
+glm::vec4 phongSample(const RayTraceScene &scene,
+                      glm::vec3 normal,
+                      glm::vec3 directionToCamera,
+                      const SceneMaterial &material,
+                      const SceneLightData &light,
+                      glm::vec3 texture,
+                      const LightSample &sample) {
+    float dotProduct = glm::dot(normal, sample.direction);
+    if (dotProduct <= 0) {
+        return glm::vec4(0.0f);
+    }
+
+    float attenuation = 1.0f / (light.function.x +
+                                light.function.y * sample.distance +
+                                light.function.z * sample.distance * sample.distance);
+    attenuation = glm::min(attenuation, 1.0f);
+
+    glm::vec4 diffuseBlend = glm::mix(material.cDiffuse * scene.getGlobalData().kd, glm::vec4(texture, 0.0f), material.blend);
+    glm::vec4 illumination = diffuseBlend * dotProduct * light.color * attenuation;
+    illumination.a = 0.0f;
+
+    glm::vec3 reflection = glm::reflect(sample.direction, normal);
+    float specAngle = glm::dot(glm::normalize(-reflection), directionToCamera);
+    if (specAngle > 0) {
+        float specFactor = glm::pow(specAngle, material.shininess);
+        glm::vec3 specular = material.cSpecular * scene.getGlobalData().ks * specFactor * light.color * attenuation;
+        illumination += glm::vec4(specular, 0.0f);
+    }
+    return illumination;
+}
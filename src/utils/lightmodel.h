@@ -4,13 +4,37 @@
 #include "utils/scenedata.h"
 #include "raytracer/raytracescene.h"
 #include "rgba.h"
+#include "lightsampler.h"
 
 
 
+// Light whose brightest channel is attenuated below this adds less than half a step of an 8-bit color
+const float LIGHT_CUTOFF = 1.0f / 512.0f;
+
+// The distance from a light's position past which its attenuated color falls below LIGHT_CUTOFF
+// (measured from an area light's center, so its whole rectangle is covered), or infinity.
+float lightInfluenceRadius(const SceneLightData &light);
+
+// Whether a light can light point at all: within radius (see lightInfluenceRadius) and, for a spot
+// light, inside its cone. Points it cannot light need neither shadow rays nor shading.
+bool lightReaches(const SceneLightData &light, float radius, glm::vec3 point);
+
+// The diffuse and specular light a point, spot or directional light sends to a point; nothing if the
+// light is behind the surface. Area lights are shaded one point on the light at a time, with phongSample.
 glm::vec4 phong(const RayTraceScene &scene,
            glm::vec3  position,
            glm::vec3  normal,
            glm::vec3  directionToCamera,
-           SceneMaterial material,
-           SceneLightData light,
+           const SceneMaterial &material,
+           const SceneLightData &light,
            glm::vec3 texture);
+
+// The diffuse and specular light arriving from one point on an area light (see lightsampler.h),
+// not yet divided by its pdf; nothing if the point is behind the surface
+glm::vec4 phongSample(const RayTraceScene &scene,
+                      glm::vec3 normal,
+                      glm::vec3 directionToCamera,
+                      const SceneMaterial &material,
+                      const SceneLightData &light,
+                      glm::vec3 texture,
+                      const LightSample &sample);
@@ -0,0 +1,52 @@
+#include "lightsampler.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+// Helper function returning a random number in [0, 1)
+float randomUnit() {
+    return static_cast<float>(rand()) / (static_cast<float>(RAND_MAX) + 1.0f);
+}
+
+int areaLightSampleCount(const SceneLightData &light, int defaultCount) {
+    return std::max(light.samples > 0 ? light.samples : defaultCount, 1);
+}
+
+float areaLightArea(const SceneLightData &light) {
+    // a light with no area still has a position to sample, and every sample then stands for all of it
+    return std::max(light.width * light.height, 1e-8f);
+}
+
+void sampleAreaLight(const SceneLightData &light, glm::vec3 point, int count, std::vector<LightSample> &samples) {
+    glm::vec3 lightNormal = glm::normalize(glm::vec3(light.dir));
+    glm::vec3 upVector = (std::abs(glm::dot(lightNormal, glm::vec3(0, 1, 0))) > 0.9f) ?
+                             glm::vec3(1, 0, 0) : glm::vec3(0, 1, 0);
+    glm::vec3 lightU = glm::normalize(glm::cross(lightNormal, upVector));
+    glm::vec3 lightV = glm::normalize(glm::cross(lightU, lightNormal));
+
+    // the rows, shuffled so that each column is paired with a random row
+    std::vector<int> rows(count);
+    for (int i = 0; i < count; i++) {
+        rows[i] = i;
+    }
+    for (int i = count - 1; i > 0; i--) {
+        std::swap(rows[i], rows[rand() % (i + 1)]);
+    }
+
+    // points are uniform over the light
+    float pdf = 1.0f / areaLightArea(light);
+
+    samples.clear();
+    for (int i = 0; i < count; i++) {
+        float u = light.width * ((i + randomUnit()) / count - 0.5f);
+        float v = light.height * ((rows[i] + randomUnit()) / count - 0.5f);
+
+        LightSample sample;
+        sample.position = glm::vec3(light.pos) + (u * lightU) + (v * lightV);
+        glm::vec3 toLight = sample.position - point;
+        sample.distance = std::max(glm::length(toLight), 1e-6f);
+        sample.direction = toLight / sample.distance;
+        sample.pdf = pdf;
+        samples.push_back(sample);
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <vector>
+#include "utils/scenedata.h"
+
+// Sampling of area lights.
+//
+// Every hit draws one set of points on an area light, and both its shadow rays and its shading use
+// those same points, so a point's light only counts when that point is visible. The points are
+// stratified: the light is cut into count rows and count columns, and each point takes its own row
+// and column (in shuffled pairs), so even a few points spread over the whole light.
+
+struct LightSample {
+    glm::vec3 position;  // on the light
+    glm::vec3 direction; // unit, from the shaded point towards position
+    float distance;      // from the shaded point to position
+    float pdf;           // of drawing position, with respect to the light's area
+};
+
+// The number of points drawn on an area light per hit: the light's own "samples", or defaultCount
+int areaLightSampleCount(const SceneLightData &light, int defaultCount);
+
+// Replaces samples with count stratified points on an area light, as seen from point
+void sampleAreaLight(const SceneLightData &light, glm::vec3 point, int count, std::vector<LightSample> &samples);
+
+// The light's area, which turns the average of f / pdf over the samples into the average of f over the light
+float areaLightArea(const SceneLightData &light);
@@ -0,0 +1,74 @@
+#include "renderstats.h"
+
+#include <sstream>
+
+namespace RenderStats {
+
+const char *COUNTER_NAMES[CounterCount] = {
+    "primaryRays", "reflectionRays", "refractionRays", "shadowRays", "lensRays", "lensRejectedRays",
+    "nodeVisits", "sphereTests", "cubeTests", "coneTests", "cylinderTests", "hits", "pixels", "pixelSamples",
+    "texturePageReads", "culledLights", "occluderCacheHits",
+    "occluderCacheMisses"
+};
+
+const char *TIMER_NAMES[TimerCount] = {
+    "parse", "textureLoad", "build", "render", "encode"
+};
+
+Stats& Stats::operator+=(const Stats &other) {
+    for (int i = 0; i < CounterCount; i++) {
+        counters[i] += other.counters[i];
+    }
+    for (int i = 0; i < TimerCount; i++) {
+        seconds[i] += other.seconds[i];
+    }
+    return *this;
+}
+
+std::string Stats::toJson() const {
+    std::ostringstream json;
+    json << "{\n  \"counters\": {";
+    for (int i = 0; i < CounterCount; i++) {
+        json << (i > 0 ? "," : "") << "\n    \"" << COUNTER_NAMES[i] << "\": " << counters[i];
+    }
+    double samplesPerPixel = counters[Pixels] > 0 ? static_cast<double>(counters[PixelSamples]) / counters[Pixels] : 0.0;
+    json << ",\n    \"samplesPerPixel\": " << samplesPerPixel;
+    json << "\n  },\n  \"seconds\": {";
+    for (int i = 0; i < TimerCount; i++) {
+        json << (i > 0 ? "," : "") << "\n    \"" << TIMER_NAMES[i] << "\": " << seconds[i];
+    }
+    json << "\n  }\n}\n";
+    return json.str();
+}
+
+std::string Stats::toText() const {
+    std::ostringstream text;
+    for (int i = 0; i < CounterCount; i++) {
+        text << COUNTER_NAMES[i] << ": " << counters[i] << "\n";
+    }
+    for (int i = 0; i < TimerCount; i++) {
+        text << TIMER_NAMES[i] << ": " << seconds[i] << " s\n";
+    }
+    return text.str();
+}
+
+Stats& local() {
+    static thread_local Stats stats;
+    return stats;
+}
+
+Stats take() {
+    Stats stats = local();
+    local() = Stats();
+    return stats;
+}
+
+ScopedTimer::ScopedTimer(Timer timer)
+    : m_timer(timer), m_start(std::chrono::steady_clock::now())
+{}
+
+ScopedTimer::~ScopedTimer() {
+    local().seconds[m_timer] += std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+}
+
+}
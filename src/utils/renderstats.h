@@ -0,0 +1,96 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Counters and timers of where render time goes, kept per thread so the hot paths never contend.
+// The RT_STAT_* macros below are the only way the renderer touches them: unless the build defines
+// RT_ENABLE_STATS (cmake -DRT_ENABLE_STATS=ON) they expand to nothing, so they cost nothing.
+//
+// A job's statistics are whatever its thread gathered between two calls of RenderStats::take().
+
+namespace RenderStats {
+
+enum Counter {
+    PrimaryRays,
+    ReflectionRays,
+    RefractionRays,
+    ShadowRays,
+    LensRays,
+    LensRejectedRays,
+    NodeVisits,
+    SphereTests,
+    CubeTests,
+    ConeTests,
+    CylinderTests,
+    Hits,
+    Pixels,
+    PixelSamples,
+    TexturePageReads,
+    CulledLights,
+    OccluderCacheHits,
+    OccluderCacheMisses,
+    CounterCount
+};
+
+enum Timer {
+    Parse,
+    TextureLoad,
+    Build,
+    Render,
+    Encode,
+    TimerCount
+};
+
+struct Stats {
+    std::uint64_t counters[CounterCount] = {};
+    double seconds[TimerCount] = {};
+
+    Stats& operator+=(const Stats &other);
+
+    // A JSON object with every counter and timer
+    std::string toJson() const;
+
+    // One "name: value" line per counter and timer
+    std::string toText() const;
+};
+
+// The calling thread's statistics
+Stats& local();
+
+// Returns the calling thread's statistics and starts them over
+Stats take();
+
+// Adds the time until it goes out of scope to a timer of the calling thread
+class ScopedTimer
+{
+public:
+    ScopedTimer(Timer timer);
+    ~ScopedTimer();
+
+private:
+    Timer m_timer;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+// Whether the build gathers statistics at all
+constexpr bool enabled() {
+#ifdef RT_ENABLE_STATS
+    return true;
+#else
+    return false;
+#endif
+}
+
+}
+
+#ifdef RT_ENABLE_STATS
+#define RT_STAT_INC(counter) (++RenderStats::local().counters[RenderStats::counter])
+#define RT_STAT_ADD(counter, n) (RenderStats::local().counters[RenderStats::counter] += (n))
+#define RT_STAT_TIMER(timer) RenderStats::ScopedTimer rtStatTimer##timer(RenderStats::timer)
+#else
+#define RT_STAT_INC(counter) ((void)0)
+#define RT_STAT_ADD(counter, n) ((void)0)
+#define RT_STAT_TIMER(timer) ((void)0)
+#endif
@@ -56,6 +56,7 @@ struct SceneLight {
     float angle;    // Only applicable to spot lights, in RADIANS
 
     float width, height; // No longer supported (area lights)
+    int samples;         // Only applicable to area lights: points drawn on the light per hit, or 0 for the render's default
 };
 
 // Struct which contains data for a single light with CTM applied
@@ -73,6 +74,7 @@ struct SceneLightData {
     float angle;    // Only applicable to spot lights, in RADIANS
 
     float width, height; // No longer supported (area lights)
+    int samples;         // Only applicable to area lights: points drawn on the light per hit, or 0 for the render's default
 };
 
 // Struct which contains data for the camera of a scene
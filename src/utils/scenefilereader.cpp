@@ -213,7 +213,7 @@ bool ScenefileReader::parseGlobalData(const QJsonObject &globalData) {
  */
 bool ScenefileReader::parseLightData(const QJsonObject &lightData, SceneNode *node) {
     QStringList requiredFields = {"type", "color"};
-    QStringList optionalFields = {"name", "attenuationCoeff", "direction", "penumbra", "angle", "width", "height"};
+    QStringList optionalFields = {"name", "attenuationCoeff", "direction", "penumbra", "angle", "width", "height", "samples"};
     QStringList allFields = requiredFields + optionalFields;
     for (auto &field : lightData.keys()) {
         if (!allFields.contains(field)) {
@@ -407,6 +407,15 @@ bool ScenefileReader::parseLightData(const QJsonObject &lightData, SceneNode *no
             light->width = lightData["width"].toDouble();
             light->height = lightData["height"].toDouble();
 
+            // Parse the optional sample count
+            if (lightData.contains("samples")) {
+                if (!lightData["samples"].isDouble() || lightData["samples"].toInt() < 1) {
+                    std::cout << "area light samples must be a positive integer" << std::endl;
+                    return false;
+                }
+                light->samples = lightData["samples"].toInt();
+            }
+
             // Parse attenuation coefficient
             if (!lightData["attenuationCoeff"].isArray()) {
                 std::cout << "area light attenuationCoeff must be of type array" << std::endl;
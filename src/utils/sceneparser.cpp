@@ -3,6 +3,8 @@
 #include <glm/gtx/transform.hpp>
 #include <iostream>
 #include "lensfilereader.h"
+#include "animation.h"
+#include "tracelog.h"
 
 void traverseSceneGraph(SceneNode* node, glm::mat4 parentCTM, std::vector<RenderShapeData> &shapes, std::vector<SceneLightData> &lights) {
     glm::mat4 currentCTM = parentCTM;
@@ -39,6 +41,7 @@ void traverseSceneGraph(SceneNode* node, glm::mat4 parentCTM, std::vector<Render
         lightData.type = light->type;
         lightData.color = light->color;
         lightData.function = light->function;
+        lightData.samples = light->samples;
 
         switch (light->type) {
         case LightType::LIGHT_POINT:
@@ -89,6 +92,7 @@ void traverseSceneGraph(SceneNode* node, glm::mat4 parentCTM, std::vector<Render
 }
 
 bool SceneParser::parseScene(std::string sceneFilepath, RenderData &renderData) {
+    TraceLog::Span span("parse scene", "io", TraceLog::isEnabled() ? "{\"path\": " + TraceLog::quote(sceneFilepath) + "}" : "");
     ScenefileReader sceneFileReader = ScenefileReader(sceneFilepath);
     bool success = sceneFileReader.readJSON();
     if (!success) {
@@ -119,3 +123,7 @@ bool SceneParser::parseLens(std::string lensFilepath, RenderData &renderData) {
 
     return true;
 }
+
+bool SceneParser::parseAnimation(std::string animationFilepath, Animation &animation) {
+    return animation.readJSON(animationFilepath);
+}
@@ -21,6 +21,8 @@ struct RenderData {
     std::vector<LensInterface> lensInterfaces;
 };
 
+class Animation;
+
 class SceneParser {
 public:
     // Parse the scene and store the results in renderData.
@@ -29,4 +31,6 @@ public:
     // @return            A boolean value indicating whether the parse was successful.
     static bool parseScene(std::string sceneFilepath, RenderData &renderData);
     static bool parseLens(std::string lensFilepath, RenderData &renderData);
+    // Parse an animation file (see Animation) along with the base scene it names.
+    static bool parseAnimation(std::string animationFilepath, Animation &animation);
 };
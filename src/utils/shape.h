@@ -1,6 +1,7 @@
 #ifndef SHAPE_H
 #define SHAPE_H
 
+#include <cmath>
 #include <glm/glm.hpp>
 #include "scenedata.h"
 #include "boundingbox.h"
@@ -13,6 +14,7 @@ public:
     Shape(const glm::mat4& ctm, const SceneMaterial& material, const glm::vec3 velocity, const Image* image)
         : m_material(material), m_ctm(ctm), m_image(image), m_velocity(velocity) {
         m_inverseCTM = glm::inverse(m_ctm);
+        m_scale = std::cbrt(std::abs(glm::determinant(glm::mat3(m_ctm))));
     }
 
     const SceneMaterial& getMaterial() const {
@@ -39,7 +41,9 @@ public:
 
     virtual double surfaceArea() = 0;
 
-    virtual glm::vec3 getTexture(const glm::vec3& intersection) = 0;
+    // @param footprint The width a pixel covers in world space around the intersection, or 0 for
+    //                  an unfiltered lookup (see sampleTexture).
+    virtual glm::vec3 getTexture(const glm::vec3& intersection, float footprint = 0.0f) = 0;
 
     virtual void id() = 0;
 
@@ -47,6 +51,7 @@ protected:
     SceneMaterial m_material;
     glm::mat4 m_ctm;
     glm::mat4 m_inverseCTM;
+    float m_scale; // how much the ctm scales lengths, on average
     glm::vec3 m_velocity;
     const Image* m_image;
 };
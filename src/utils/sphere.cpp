@@ -1,4 +1,6 @@
 #include "sphere.h"
+#include "texturesampler.h"
+#include "renderstats.h"
 #include "imagereader.h"
 #include <iostream>
 
@@ -20,6 +22,7 @@ glm::vec3 Sphere::calcNormal(const glm::vec3 point) {
 
 // Method to calculate the intersection with a ray
 bool Sphere::calcIntersection(const glm::vec3 rayOrigin, const glm::vec3 rayDirection, glm::vec3& intersectionPoint, float& t, float time, float vel) {
+    RT_STAT_INC(SphereTests);
 
     glm::vec3 centerWorld = glm::vec3(m_ctm * glm::vec4(m_center, 1.0f));
     glm::vec3 movingCenter = centerWorld - time * m_velocity * glm::vec3(0, vel, 0);
@@ -77,7 +80,7 @@ double Sphere::surfaceArea() {
     return 4.0 * M_PI * m_radius * m_radius;
 }
 
-glm::vec3 Sphere::getTexture(const glm::vec3& intersection) {
+glm::vec3 Sphere::getTexture(const glm::vec3& intersection, float footprint) {
     if (m_image == nullptr){
         return glm::vec3(0, 0, 0);
     }
@@ -91,14 +94,9 @@ glm::vec3 Sphere::getTexture(const glm::vec3& intersection) {
     u = theta >= 0 ? 1.f - (theta / (2.f * M_PI)) : -theta / (2.f * M_PI);
     v = phi / M_PI + 0.5f;
 
-    int x = static_cast<int>(std::floor(u * m_material.textureMap.repeatU * m_image->width)) % m_image->width;
-    int y = static_cast<int>(std::floor((1 - v) * m_material.textureMap.repeatV * m_image->height)) % m_image->height;
-
-    if (u == 1.0f) x = m_material.textureMap.repeatU * m_image->width - 1;
-    if (v == 0.0f) y = m_material.textureMap.repeatV * m_image->height - 1;
-
-    RGBA pixel = m_image->data[y * m_image->width + x];
-    return glm::vec3(pixel.r / 255.0f, pixel.g / 255.0f, pixel.b / 255.0f);
+    // the footprint in (u, v): v spans half a meridian, which is pi / 2 long in object space
+    float uvFootprint = footprint / m_scale * 2.0f / static_cast<float>(M_PI);
+    return sampleTexture(*m_image, m_material.textureMap, u, v, uvFootprint);
 }
 
 void Sphere::setRadius(float r) {
@@ -0,0 +1,119 @@
+#include "textureatlas.h"
+
+#include <algorithm>
+
+// Helper function rounding a size up to the atlas alignment
+int alignUp(int size) {
+    return (size + ATLAS_ALIGNMENT - 1) / ATLAS_ALIGNMENT * ATLAS_ALIGNMENT;
+}
+
+// A texture's place in an atlas
+struct Placement {
+    int index; // in the images being packed
+    int atlas;
+    int x;
+    int y;
+};
+
+// Helper function to build an atlas out of its textures' mip levels
+std::shared_ptr<const Image> makeAtlas(int height, const std::vector<Placement> &placements,
+                                       const std::vector<std::shared_ptr<const Image>> &images) {
+    auto atlas = std::make_shared<Image>(Image{ATLAS_SIZE, height, {}});
+
+    for (int level = 0; level < ATLAS_LEVELS; level++) {
+        int width = std::max(ATLAS_SIZE >> level, 1);
+        int levelHeight = std::max(height >> level, 1);
+        int tilesX = (width + 7) / 8;
+        int tilesY = (levelHeight + 7) / 8;
+        atlas->levels.push_back(MipLevel{width, levelHeight, tilesX, std::vector<RGBA>(tilesX * tilesY * 64)});
+    }
+
+    for (const Placement &placement : placements) {
+        const Image &image = *images[placement.index];
+        int levels = std::min(static_cast<int>(image.levels.size()), ATLAS_LEVELS);
+
+        for (int level = 0; level < levels; level++) {
+            const MipLevel &source = image.levels[level];
+            MipLevel &target = atlas->levels[level];
+            int x0 = placement.x >> level;
+            int y0 = placement.y >> level;
+
+            for (int y = 0; y < source.height; y++) {
+                for (int x = 0; x < source.width; x++) {
+                    target.texel(x0 + x, y0 + y) = source.texel(x, y);
+                }
+            }
+        }
+    }
+    return atlas;
+}
+
+void packAtlases(std::vector<std::shared_ptr<const Image>> &images) {
+    std::vector<int> small;
+    for (int i = 0; i < (int)images.size(); i++) {
+        const std::shared_ptr<const Image> &image = images[i];
+        if (image != nullptr && image->pages == nullptr && image->atlas == nullptr &&
+            image->width <= ATLAS_MAX_TEXTURE && image->height <= ATLAS_MAX_TEXTURE) {
+            small.push_back(i);
+        }
+    }
+    // a single texture gains nothing from an atlas of its own
+    if (small.size() < 2) {
+        return;
+    }
+
+    // shelf packing, tallest textures first: each shelf is as tall as its first texture
+    std::sort(small.begin(), small.end(), [&](int a, int b) { return images[a]->height > images[b]->height; });
+
+    std::vector<Placement> placements;
+    std::vector<int> atlasHeights = {0};
+    int shelfX = 0, shelfY = 0, shelfHeight = 0;
+    for (int i : small) {
+        int width = alignUp(images[i]->width);
+        int height = alignUp(images[i]->height);
+
+        if (shelfX + width > ATLAS_SIZE) {
+            shelfY += shelfHeight;
+            shelfX = 0;
+            shelfHeight = 0;
+        }
+        if (shelfY + height > ATLAS_SIZE) {
+            atlasHeights.push_back(0);
+            shelfX = 0;
+            shelfY = 0;
+            shelfHeight = 0;
+        }
+
+        int atlas = static_cast<int>(atlasHeights.size()) - 1;
+        placements.push_back(Placement{i, atlas, shelfX, shelfY});
+        shelfX += width;
+        shelfHeight = std::max(shelfHeight, height);
+        atlasHeights[atlas] = std::max(atlasHeights[atlas], shelfY + shelfHeight);
+    }
+
+    for (int atlas = 0; atlas < (int)atlasHeights.size(); atlas++) {
+        std::vector<Placement> contents;
+        for (const Placement &placement : placements) {
+            if (placement.atlas == atlas) {
+                contents.push_back(placement);
+            }
+        }
+        std::shared_ptr<const Image> atlasImage = makeAtlas(atlasHeights[atlas], contents, images);
+
+        for (const Placement &placement : contents) {
+            const Image &image = *images[placement.index];
+            auto view = std::make_shared<Image>(Image{image.width, image.height, {}});
+            int levels = std::min(static_cast<int>(image.levels.size()), ATLAS_LEVELS);
+            for (int level = 0; level < levels; level++) {
+                const MipLevel &source = image.levels[level];
+                view->levels.push_back(MipLevel{source.width, source.height, source.tilesX, {}});
+            }
+            view->atlas = atlasImage;
+            view->atlasX = placement.x;
+            view->atlasY = placement.y;
+
+            // the texture's own texels are freed once no one else holds it
+            images[placement.index] = view;
+        }
+    }
+}
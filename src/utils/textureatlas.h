@@ -0,0 +1,24 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "imagereader.h"
+
+// Packing of small textures into a few large atlases.
+//
+// Each packed texture becomes a view into its atlas (Image::atlas), and lookups address its
+// sub-rectangle: coordinates wrap within the texture's own size before the offset is added, so
+// repeatU/repeatV tiling and bilinear filtering never read a neighbour's texels.
+// Textures start at multiples of ATLAS_ALIGNMENT texels, so their first ATLAS_LEVELS mip levels
+// land at whole texels of the atlas's levels without overlapping; the atlas's levels are made of
+// the textures' own levels rather than downsampled from the atlas, and a packed texture has at
+// most ATLAS_LEVELS levels.
+
+const int ATLAS_SIZE = 2048;       // width of every atlas, and the most rows one holds
+const int ATLAS_MAX_TEXTURE = 256; // textures larger than this in either direction are left alone
+const int ATLAS_ALIGNMENT = 16;
+const int ATLAS_LEVELS = 5;        // log2(ATLAS_ALIGNMENT) + 1
+
+// Replaces the small textures among images with views into shared atlases, keeping the rest.
+// Null entries and streamed textures are left as they are.
+void packAtlases(std::vector<std::shared_ptr<const Image>> &images);
@@ -0,0 +1,173 @@
+#include "texturecache.h"
+#include "renderstats.h"
+#include "textureatlas.h"
+#include "texturecompression.h"
+#include "tracelog.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QThreadPool>
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+
+// Helper function returning the key a texture file is cached under: its canonical path if it exists
+std::string canonicalPath(const std::string &filename) {
+    QString canonical = QFileInfo(QString::fromStdString(filename)).canonicalFilePath();
+    return canonical.isEmpty() ? filename : canonical.toStdString();
+}
+
+std::shared_ptr<const Image> TextureCache::get(const std::string &filename) {
+    return getAll({filename})[filename];
+}
+
+void TextureCache::setAtlases(bool atlases) {
+    m_atlases = atlases;
+}
+
+void TextureCache::setCompression(float maxError) {
+    m_maxCompressionError = maxError;
+}
+
+void TextureCache::setStreaming(std::size_t budgetBytes, const QString &cacheDir) {
+    m_pageCache = std::make_unique<PageCache>(budgetBytes);
+    m_cacheDir = cacheDir;
+}
+
+Image* TextureCache::load(const std::string &filename, const std::string &key) {
+    if (m_pageCache == nullptr) {
+        return loadImageFromFile(filename);
+    }
+
+    // the texture file is named after the source's path, size and modification time, so an edited texture is converted again
+    QFileInfo info(QString::fromStdString(filename));
+    QString source = QString::fromStdString(key) + "|" + QString::number(info.size()) + "|" +
+                     QString::number(info.lastModified().toMSecsSinceEpoch());
+    QString name = QString::fromUtf8(QCryptographicHash::hash(source.toUtf8(), QCryptographicHash::Md5).toHex());
+    QString texturePath = QDir(m_cacheDir).filePath(name + ".rtex");
+
+    Image* image = openTextureFile(texturePath, *m_pageCache);
+    if (image != nullptr) {
+        return image;
+    }
+
+    Image* decoded = loadImageFromFile(filename);
+    if (decoded == nullptr) {
+        return nullptr;
+    }
+    if (!QDir().mkpath(m_cacheDir) || !writeTextureFile(texturePath, *decoded)) {
+        std::cerr << "Warning: could not write \"" << texturePath.toStdString() << "\"; keeping \""
+                  << filename << "\" in memory" << std::endl;
+        return decoded;
+    }
+    delete decoded;
+
+    image = openTextureFile(texturePath, *m_pageCache);
+    if (image == nullptr) {
+        std::cerr << "Error: could not read back \"" << texturePath.toStdString() << "\"" << std::endl;
+    }
+    return image;
+}
+
+std::map<std::string, std::shared_ptr<const Image>> TextureCache::getAll(const std::vector<std::string> &filenames) {
+    std::vector<std::string> distinct(filenames.begin(), filenames.end());
+    std::sort(distinct.begin(), distinct.end());
+    distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+
+    std::vector<std::string> keys;
+    for (const std::string &filename : distinct) {
+        keys.push_back(canonicalPath(filename));
+    }
+
+    std::map<std::string, std::shared_ptr<const Image>> result;
+    std::vector<std::shared_ptr<Pending>> claimed(distinct.size()); // decoded by this call
+    std::vector<std::shared_ptr<Pending>> waiting(distinct.size()); // decoded by another thread
+    std::vector<int> toDecode;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (int i = 0; i < (int)distinct.size(); i++) {
+            auto pending = m_pending.find(keys[i]);
+            if (m_failed.count(keys[i]) > 0) {
+                result[distinct[i]] = nullptr;
+            } else if (std::shared_ptr<const Image> image = m_images[keys[i]].lock()) {
+                result[distinct[i]] = image;
+            } else if (pending != m_pending.end()) {
+                waiting[i] = pending->second;
+            } else {
+                claimed[i] = std::make_shared<Pending>();
+                m_pending[keys[i]] = claimed[i];
+                toDecode.push_back(i);
+            }
+        }
+    }
+
+    // decoding happens outside the lock, distinct files in parallel
+    std::vector<std::shared_ptr<const Image>> images(distinct.size());
+    auto decode = [&](int i) {
+        RT_STAT_TIMER(TextureLoad);
+        TraceLog::Span span("decode texture", "io", TraceLog::isEnabled() ? "{\"path\": " + TraceLog::quote(keys[i]) + "}" : "");
+        images[i] = std::shared_ptr<const Image>(load(distinct[i], keys[i]));
+    };
+    if (toDecode.size() == 1) {
+        decode(toDecode[0]);
+    } else if (toDecode.size() > 1) {
+        std::atomic<int> next = 0;
+        auto decoder = [&]() {
+            int i;
+            while ((i = next++) < (int)toDecode.size()) {
+                decode(toDecode[i]);
+            }
+        };
+
+        QThreadPool pool;
+        int decoders = std::min((int)toDecode.size(), pool.maxThreadCount());
+        for (int d = 0; d < decoders; d++) {
+            pool.start(decoder);
+        }
+        pool.waitForDone();
+    }
+
+    if (m_atlases || m_maxCompressionError > 0.0f) {
+        std::vector<std::shared_ptr<const Image>> decoded;
+        for (int i : toDecode) {
+            decoded.push_back(images[i]);
+        }
+        if (m_atlases) {
+            packAtlases(decoded);
+        }
+        if (m_maxCompressionError > 0.0f) {
+            TraceLog::Span span("compress textures", "io");
+            compressTextures(decoded, m_maxCompressionError);
+        }
+        for (int j = 0; j < (int)toDecode.size(); j++) {
+            images[toDecode[j]] = decoded[j];
+        }
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (int i : toDecode) {
+            if (images[i] == nullptr) {
+                m_failed.insert(keys[i]);
+            }
+            m_images[keys[i]] = images[i];
+            m_pending.erase(keys[i]);
+            claimed[i]->image = images[i];
+            claimed[i]->done = true;
+            result[distinct[i]] = images[i];
+        }
+        m_decoded.notify_all();
+
+        // this call's own textures are published first, so threads waiting on each other always finish
+        for (int i = 0; i < (int)distinct.size(); i++) {
+            if (waiting[i] != nullptr) {
+                std::shared_ptr<Pending> other = waiting[i];
+                m_decoded.wait(lock, [&]() { return other->done; });
+                result[distinct[i]] = other->image;
+            }
+        }
+    }
+    return result;
+}
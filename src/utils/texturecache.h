@@ -0,0 +1,72 @@
+#pragma once
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include "imagereader.h"
+#include "texturepager.h"
+
+// A thread-safe cache of decoded textures keyed by canonical path, so "textures/a.png" and
+// "scenefiles/../textures/a.png" are decoded once and shared by every shape that uses them.
+// Textures are owned by the shapes' geometry through shared pointers: the cache only remembers
+// them while some geometry still uses them, and each one is freed along with its last user.
+// Files that fail to load are remembered too, so a missing file is only reported once.
+// With streaming on, textures are paged in from pre-tiled files instead (see texturepager.h).
+// With atlases on, the small textures loaded together are packed into shared atlases (see textureatlas.h).
+// With compression on, textures in memory are kept in compressed formats (see texturecompression.h).
+
+class TextureCache
+{
+public:
+    TextureCache() = default;
+
+    TextureCache(const TextureCache &) = delete;
+    TextureCache &operator=(const TextureCache &) = delete;
+
+    // Returns the decoded texture, loading it if no one uses it yet.
+    // Returns nullptr if the file could not be loaded.
+    std::shared_ptr<const Image> get(const std::string &filename);
+
+    // Returns the decoded textures of every file, loading the ones not in use yet in parallel
+    // (and packing them into atlases, if enabled). Files that could not be loaded map to nullptr.
+    std::map<std::string, std::shared_ptr<const Image>> getAll(const std::vector<std::string> &filenames);
+
+    // Streams textures instead of decoding them into memory: each file is converted once into a texture
+    // file in cacheDir (kept for later runs), whose pages are read when rendering first needs them,
+    // keeping at most budgetBytes of pages of all textures in memory.
+    // Must be called before the first texture is requested.
+    void setStreaming(std::size_t budgetBytes, const QString &cacheDir);
+
+    // Packs the small textures of each getAll call into atlases. Must be called before the first texture is requested.
+    void setAtlases(bool atlases);
+
+    // Compresses each texture kept in memory (atlases included) into the smallest format whose error stays
+    // within maxError (root mean square, 0-255 per channel); 0 keeps them uncompressed.
+    // Must be called before the first texture is requested.
+    void setCompression(float maxError);
+
+private:
+    // Decodes the file, or opens its texture file when streaming
+    Image* load(const std::string &filename, const std::string &key);
+
+    // A texture being decoded by one thread that others may be waiting for
+    struct Pending {
+        std::shared_ptr<const Image> image;
+        bool done = false;
+    };
+
+    std::map<std::string, std::weak_ptr<const Image>> m_images;
+    std::map<std::string, std::shared_ptr<Pending>> m_pending;
+    std::set<std::string> m_failed;
+    std::mutex m_mutex;
+    std::condition_variable m_decoded;
+
+    std::unique_ptr<PageCache> m_pageCache; // set when streaming
+    bool m_atlases = false;
+    float m_maxCompressionError = 0.0f;
+    QString m_cacheDir;
+};
@@ -0,0 +1,273 @@
+#include "texturecompression.h"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+// Helper function returning the index of the 4x4 block holding texel (x, y), in tile order
+int blockIndex(const MipLevel &level, int x, int y) {
+    return ((((y >> 3) * level.tilesX + (x >> 3)) << 2) + (((y >> 2) & 1) << 1) + ((x >> 2) & 1));
+}
+
+// Helper function to pack a color into RGB565
+std::uint16_t to565(const glm::vec3 &color) {
+    glm::vec3 c = glm::clamp(color, 0.0f, 255.0f);
+    int r = static_cast<int>(c.r * 31.0f / 255.0f + 0.5f);
+    int g = static_cast<int>(c.g * 63.0f / 255.0f + 0.5f);
+    int b = static_cast<int>(c.b * 31.0f / 255.0f + 0.5f);
+    return static_cast<std::uint16_t>((r << 11) | (g << 5) | b);
+}
+
+// Helper function to unpack an RGB565 color
+glm::ivec3 from565(std::uint16_t color) {
+    int r = (color >> 11) & 31, g = (color >> 5) & 63, b = color & 31;
+    return glm::ivec3((r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2));
+}
+
+// Helper function returning the four colors a BC1 block's end points stand for
+void bc1Colors(std::uint16_t c0, std::uint16_t c1, glm::ivec3 colors[4]) {
+    colors[0] = from565(c0);
+    colors[1] = from565(c1);
+    colors[2] = (2 * colors[0] + colors[1]) / 3;
+    colors[3] = (colors[0] + 2 * colors[1]) / 3;
+}
+
+// Helper function to encode one 4x4 block: the end points are the extremes of its colors along
+// their principal axis, and every texel takes the nearest of the four colors between them
+std::uint64_t encodeBlock(const MipLevel &level, int bx, int by) {
+    glm::vec3 colors[16];
+    int count = 0;
+    for (int y = by; y < std::min(by + 4, level.height); y++) {
+        for (int x = bx; x < std::min(bx + 4, level.width); x++) {
+            const RGBA &t = level.texel(x, y);
+            colors[count++] = glm::vec3(t.r, t.g, t.b);
+        }
+    }
+
+    glm::vec3 mean(0.0f);
+    for (int i = 0; i < count; i++) {
+        mean += colors[i];
+    }
+    mean /= static_cast<float>(count);
+
+    glm::mat3 covariance(0.0f);
+    for (int i = 0; i < count; i++) {
+        glm::vec3 d = colors[i] - mean;
+        covariance += glm::outerProduct(d, d);
+    }
+    glm::vec3 axis(1.0f);
+    for (int i = 0; i < 8; i++) {
+        glm::vec3 next = covariance * axis;
+        float length = glm::length(next);
+        if (length < 1e-6f) {
+            break;
+        }
+        axis = next / length;
+    }
+
+    float lowest = 0.0f, highest = 0.0f;
+    for (int i = 0; i < count; i++) {
+        float t = glm::dot(colors[i] - mean, axis);
+        lowest = std::min(lowest, t);
+        highest = std::max(highest, t);
+    }
+
+    std::uint16_t c0 = to565(mean + highest * axis);
+    std::uint16_t c1 = to565(mean + lowest * axis);
+    // c0 > c1 selects the four-color mode
+    if (c0 < c1) {
+        std::swap(c0, c1);
+    }
+    std::uint64_t block = c0 | (static_cast<std::uint64_t>(c1) << 16);
+    if (c0 == c1) {
+        return block;
+    }
+
+    glm::ivec3 palette[4];
+    bc1Colors(c0, c1, palette);
+    for (int y = by; y < std::min(by + 4, level.height); y++) {
+        for (int x = bx; x < std::min(bx + 4, level.width); x++) {
+            const RGBA &t = level.texel(x, y);
+            glm::ivec3 color(t.r, t.g, t.b);
+            int best = 0, bestDistance = 1 << 30;
+            for (int i = 0; i < 4; i++) {
+                glm::ivec3 d = color - palette[i];
+                int distance = d.x * d.x + d.y * d.y + d.z * d.z;
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = i;
+                }
+            }
+            block |= static_cast<std::uint64_t>(best) << (32 + 2 * (((y & 3) << 2) + (x & 3)));
+        }
+    }
+    return block;
+}
+
+// Helper function to build a 256-color palette by median cut over (a sample of) the texels
+std::vector<RGBA> medianCut(const MipLevel &level) {
+    std::vector<glm::ivec3> colors;
+    int step = std::max(1, level.width * level.height / 65536);
+    for (int i = 0; i < level.width * level.height; i += step) {
+        const RGBA &t = level.texel(i % level.width, i / level.width);
+        colors.push_back(glm::ivec3(t.r, t.g, t.b));
+    }
+
+    // boxes are ranges of colors; the box with the widest channel is split at its median until there are 256
+    std::vector<std::pair<int, int>> boxes = {{0, static_cast<int>(colors.size())}};
+    while (boxes.size() < 256) {
+        int widest = -1, widestChannel = 0, widestRange = 0;
+        for (int b = 0; b < (int)boxes.size(); b++) {
+            if (boxes[b].second - boxes[b].first < 2) {
+                continue;
+            }
+            glm::ivec3 low(255), high(0);
+            for (int i = boxes[b].first; i < boxes[b].second; i++) {
+                low = glm::min(low, colors[i]);
+                high = glm::max(high, colors[i]);
+            }
+            for (int c = 0; c < 3; c++) {
+                if (high[c] - low[c] > widestRange) {
+                    widestRange = high[c] - low[c];
+                    widest = b;
+                    widestChannel = c;
+                }
+            }
+        }
+        if (widest < 0) {
+            break;
+        }
+
+        auto [first, last] = boxes[widest];
+        int middle = (first + last) / 2;
+        std::nth_element(colors.begin() + first, colors.begin() + middle, colors.begin() + last,
+                         [&](const glm::ivec3 &a, const glm::ivec3 &b) { return a[widestChannel] < b[widestChannel]; });
+        boxes[widest] = {first, middle};
+        boxes.push_back({middle, last});
+    }
+
+    std::vector<RGBA> palette;
+    for (auto [first, last] : boxes) {
+        glm::ivec3 sum(0);
+        for (int i = first; i < last; i++) {
+            sum += colors[i];
+        }
+        glm::ivec3 average = last > first ? sum / (last - first) : glm::ivec3(0);
+        palette.push_back(RGBA{static_cast<std::uint8_t>(average.r), static_cast<std::uint8_t>(average.g),
+                               static_cast<std::uint8_t>(average.b), 255});
+    }
+    palette.resize(256, RGBA{0, 0, 0, 255});
+    return palette;
+}
+
+// Helper function returning the root mean square error of a compressed level against the original
+float compressionError(const Image &compressed, const MipLevel &original) {
+    double sum = 0.0;
+    for (int y = 0; y < original.height; y++) {
+        for (int x = 0; x < original.width; x++) {
+            RGBA a = original.texel(x, y);
+            RGBA b = compressedTexel(compressed, compressed.levels[0], x, y);
+            double dr = a.r - b.r, dg = a.g - b.g, db = a.b - b.b;
+            sum += dr * dr + dg * dg + db * db;
+        }
+    }
+    return static_cast<float>(std::sqrt(sum / (3.0 * original.width * original.height)));
+}
+
+// Helper function to compress a texture with its own texels into the first format within maxError
+std::shared_ptr<const Image> compressImage(const std::shared_ptr<const Image> &image, float maxError) {
+    auto emptyCopy = [&](TextureFormat format) {
+        auto copy = std::make_shared<Image>(Image{image->width, image->height, {}});
+        copy->format = format;
+        for (const MipLevel &level : image->levels) {
+            copy->levels.push_back(MipLevel{level.width, level.height, level.tilesX, {}});
+        }
+        return copy;
+    };
+
+    auto bc1 = emptyCopy(TextureFormat::BC1);
+    for (int l = 0; l < (int)image->levels.size(); l++) {
+        const MipLevel &level = image->levels[l];
+        MipLevel &target = bc1->levels[l];
+        target.blocks.resize(level.texels.size() / 16);
+        for (int by = 0; by < level.height; by += 4) {
+            for (int bx = 0; bx < level.width; bx += 4) {
+                target.blocks[blockIndex(target, bx, by)] = encodeBlock(level, bx, by);
+            }
+        }
+    }
+    if (compressionError(*bc1, image->levels[0]) <= maxError) {
+        return bc1;
+    }
+
+    auto palette8 = emptyCopy(TextureFormat::Palette8);
+    palette8->palette = medianCut(image->levels[0]);
+
+    // the nearest palette entry of every color, to 5 bits per channel
+    std::vector<std::uint8_t> nearest(32 * 32 * 32);
+    for (int i = 0; i < 32 * 32 * 32; i++) {
+        glm::ivec3 color(((i >> 10) << 3) + 4, (((i >> 5) & 31) << 3) + 4, ((i & 31) << 3) + 4);
+        int best = 0, bestDistance = 1 << 30;
+        for (int p = 0; p < 256; p++) {
+            const RGBA &entry = palette8->palette[p];
+            glm::ivec3 d = color - glm::ivec3(entry.r, entry.g, entry.b);
+            int distance = d.x * d.x + d.y * d.y + d.z * d.z;
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                best = p;
+            }
+        }
+        nearest[i] = static_cast<std::uint8_t>(best);
+    }
+
+    for (int l = 0; l < (int)image->levels.size(); l++) {
+        const MipLevel &level = image->levels[l];
+        MipLevel &target = palette8->levels[l];
+        target.indices.resize(level.texels.size());
+        for (int i = 0; i < (int)level.texels.size(); i++) {
+            const RGBA &t = level.texels[i];
+            target.indices[i] = nearest[((t.r >> 3) << 10) | ((t.g >> 3) << 5) | (t.b >> 3)];
+        }
+    }
+    if (compressionError(*palette8, image->levels[0]) <= maxError) {
+        return palette8;
+    }
+    return image;
+}
+
+void compressTextures(std::vector<std::shared_ptr<const Image>> &images, float maxError) {
+    // views of the same atlas share its compressed copy
+    std::map<const Image*, std::shared_ptr<const Image>> atlases;
+
+    for (std::shared_ptr<const Image> &image : images) {
+        if (image == nullptr || image->pages != nullptr || image->format != TextureFormat::RGBA8) {
+            continue;
+        }
+        if (image->atlas == nullptr) {
+            image = compressImage(image, maxError);
+            continue;
+        }
+
+        auto it = atlases.find(image->atlas.get());
+        if (it == atlases.end()) {
+            it = atlases.emplace(image->atlas.get(), compressImage(image->atlas, maxError)).first;
+        }
+        auto view = std::make_shared<Image>(*image);
+        view->atlas = it->second;
+        image = view;
+    }
+}
+
+RGBA compressedTexel(const Image &image, const MipLevel &level, int x, int y) {
+    if (image.format == TextureFormat::Palette8) {
+        return image.palette[level.indices[level.index(x, y)]];
+    }
+
+    std::uint64_t block = level.blocks[blockIndex(level, x, y)];
+    int index = static_cast<int>((block >> (32 + 2 * (((y & 3) << 2) + (x & 3)))) & 3);
+    glm::ivec3 colors[4];
+    bc1Colors(static_cast<std::uint16_t>(block), static_cast<std::uint16_t>(block >> 16), colors);
+    const glm::ivec3 &color = colors[index];
+    return RGBA{static_cast<std::uint8_t>(color.r), static_cast<std::uint8_t>(color.g), static_cast<std::uint8_t>(color.b), 255};
+}
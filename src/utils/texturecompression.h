@@ -0,0 +1,23 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "imagereader.h"
+
+// Compressed in-memory texture formats, decoded texel by texel as they are sampled.
+//
+// BC1 stores each 4x4 block of texels in 8 bytes: two RGB565 end points and a 2-bit index per texel
+// choosing one of four colors between them (an eighth of RGBA's size). Palette8 stores one byte per
+// texel indexing a 256-color palette built by median cut (a quarter). Blocks and indices follow the
+// 8x8 tile order of MipLevel, so a tile's texels stay together. Alpha is not kept; textures are opaque.
+//
+// Each texture gets the smallest format whose root mean square error on its full-resolution level
+// stays within the allowed error, or stays RGBA.
+
+// Replaces each texture with its compressed form where one meets maxError (0-255 per channel).
+// Atlases are compressed once and their views point to the compressed atlas; null entries and
+// streamed textures are kept as they are.
+void compressTextures(std::vector<std::shared_ptr<const Image>> &images, float maxError);
+
+// Decodes texel (x, y) of a level of a BC1 or Palette8 image
+RGBA compressedTexel(const Image &image, const MipLevel &level, int x, int y);
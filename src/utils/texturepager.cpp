@@ -0,0 +1,149 @@
+#include "texturepager.h"
+#include "renderstats.h"
+
+#include <QSaveFile>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+
+// The start of every texture file, followed by the level count and each level's width, height and tiles per row
+const char TEXTURE_MAGIC[8] = {'R', 'T', 'E', 'X', '0', '0', '0', '1'};
+
+PageCache::PageCache(std::size_t budgetBytes)
+    : m_budget(budgetBytes)
+{}
+
+PageCache::Page PageCache::get(std::uint64_t key, const std::function<Page()> &load) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_pages.find(key);
+        if (it != m_pages.end()) {
+            m_lru.splice(m_lru.begin(), m_lru, it->second);
+            return it->second->second;
+        }
+    }
+
+    // pages are read outside the lock; two threads missing the same page both read it, and one copy is kept
+    Page page = load();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_pages.find(key);
+    if (it != m_pages.end()) {
+        return it->second->second;
+    }
+
+    m_lru.emplace_front(key, page);
+    m_pages[key] = m_lru.begin();
+    m_used += page->size() * sizeof(RGBA);
+
+    while (m_used > m_budget && m_lru.size() > 1) {
+        m_used -= m_lru.back().second->size() * sizeof(RGBA);
+        m_pages.erase(m_lru.back().first);
+        m_lru.pop_back();
+    }
+    return page;
+}
+
+TexturePages::TexturePages(const QString &path, std::vector<std::int64_t> levelOffsets,
+                           std::vector<std::int64_t> levelTexels, PageCache &cache)
+    : m_levelOffsets(std::move(levelOffsets)), m_levelTexels(std::move(levelTexels)),
+      m_cache(cache), m_file(path)
+{
+    static std::atomic<std::uint64_t> nextId = 0;
+    m_id = nextId++;
+}
+
+RGBA TexturePages::texel(int level, int index) const {
+    // most lookups land on the page the same thread read last
+    struct LastPage {
+        std::uint64_t key = ~0ull;
+        PageCache::Page page;
+    };
+    static thread_local LastPage last;
+
+    int page = index / PAGE_TEXELS;
+    std::uint64_t key = (m_id << 32) | (static_cast<std::uint64_t>(level) << 24) | static_cast<std::uint64_t>(page);
+    if (key != last.key) {
+        last.page = m_cache.get(key, [&]() { return loadPage(level, page); });
+        last.key = key;
+    }
+    return (*last.page)[index % PAGE_TEXELS];
+}
+
+PageCache::Page TexturePages::loadPage(int level, int page) const {
+    RT_STAT_INC(TexturePageReads);
+    std::int64_t first = static_cast<std::int64_t>(page) * PAGE_TEXELS;
+    std::int64_t count = std::min<std::int64_t>(PAGE_TEXELS, m_levelTexels[level] - first);
+    auto texels = std::make_shared<std::vector<RGBA>>(PAGE_TEXELS);
+
+    std::lock_guard<std::mutex> lock(m_fileMutex);
+    if (!m_file.isOpen() && !m_file.open(QIODevice::ReadOnly)) {
+        std::cerr << "Error: could not read texture file \"" << m_file.fileName().toStdString() << "\"" << std::endl;
+        return texels;
+    }
+    m_file.seek(m_levelOffsets[level] + first * static_cast<std::int64_t>(sizeof(RGBA)));
+    m_file.read(reinterpret_cast<char*>(texels->data()), count * sizeof(RGBA));
+    return texels;
+}
+
+bool writeTextureFile(const QString &path, const Image &image) {
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+
+    std::vector<std::int32_t> header = {static_cast<std::int32_t>(image.levels.size())};
+    for (const MipLevel &level : image.levels) {
+        header.insert(header.end(), {level.width, level.height, level.tilesX});
+    }
+    file.write(TEXTURE_MAGIC, sizeof(TEXTURE_MAGIC));
+    file.write(reinterpret_cast<const char*>(header.data()), header.size() * sizeof(std::int32_t));
+
+    for (const MipLevel &level : image.levels) {
+        file.write(reinterpret_cast<const char*>(level.texels.data()), level.texels.size() * sizeof(RGBA));
+    }
+    // only a completely written file replaces the path, so other processes never see half of one
+    return file.commit();
+}
+
+Image* openTextureFile(const QString &path, PageCache &cache) {
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return nullptr;
+    }
+
+    char magic[sizeof(TEXTURE_MAGIC)];
+    std::int32_t levelCount = 0;
+    if (file.read(magic, sizeof(magic)) != sizeof(magic) || std::memcmp(magic, TEXTURE_MAGIC, sizeof(magic)) != 0 ||
+        file.read(reinterpret_cast<char*>(&levelCount), sizeof(levelCount)) != sizeof(levelCount) ||
+        levelCount < 1 || levelCount > 32) {
+        return nullptr;
+    }
+
+    std::vector<std::int32_t> sizes(3 * levelCount);
+    qint64 sizesBytes = sizes.size() * sizeof(std::int32_t);
+    if (file.read(reinterpret_cast<char*>(sizes.data()), sizesBytes) != sizesBytes) {
+        return nullptr;
+    }
+
+    Image* image = new Image{sizes[0], sizes[1], {}};
+    std::vector<std::int64_t> offsets, texels;
+    std::int64_t offset = sizeof(TEXTURE_MAGIC) + sizeof(levelCount) + sizesBytes;
+    for (int i = 0; i < levelCount; i++) {
+        int width = sizes[3 * i], height = sizes[3 * i + 1], tilesX = sizes[3 * i + 2];
+        std::int64_t count = static_cast<std::int64_t>(tilesX) * ((height + 7) / 8) * 64;
+
+        image->levels.push_back(MipLevel{width, height, tilesX, {}});
+        offsets.push_back(offset);
+        texels.push_back(count);
+        offset += count * sizeof(RGBA);
+    }
+
+    if (file.size() < offset) {
+        delete image;
+        return nullptr;
+    }
+
+    image->pages = std::make_shared<TexturePages>(path, std::move(offsets), std::move(texels), cache);
+    return image;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <QFile>
+#include <QString>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "imagereader.h"
+
+// Streaming of textures that don't all fit in memory.
+//
+// A texture's mip chain is converted once into a pre-tiled texture file (see writeTextureFile):
+// a header with the size of every level, then each level's texels in the order MipLevel stores them.
+// Rendering opens the file instead of decoding the image and reads it in pages of PAGE_TEXELS texels
+// (64 of the 8x8 tiles, a strip 8 texels high) when a lookup first touches them. The pages of every
+// texture share one PageCache, which evicts the least recently used ones past a memory budget.
+
+const int PAGE_TEXELS = 4096;
+
+// A thread-safe LRU cache of texture pages with a fixed memory budget
+class PageCache
+{
+public:
+    using Page = std::shared_ptr<const std::vector<RGBA>>;
+
+    PageCache(std::size_t budgetBytes);
+
+    // Returns the page stored under key, calling load to read it if it is not cached.
+    // Pages still held by a caller stay valid after they are evicted.
+    Page get(std::uint64_t key, const std::function<Page()> &load);
+
+private:
+    std::size_t m_budget;
+    std::size_t m_used = 0;
+
+    std::list<std::pair<std::uint64_t, Page>> m_lru; // most recently used first
+    std::unordered_map<std::uint64_t, std::list<std::pair<std::uint64_t, Page>>::iterator> m_pages;
+    std::mutex m_mutex;
+};
+
+// The texels of an opened texture file, read a page at a time through a PageCache
+class TexturePages
+{
+public:
+    // @param levelOffsets The byte offset of each level's texels in the file.
+    // @param levelTexels The number of texels stored for each level.
+    TexturePages(const QString &path, std::vector<std::int64_t> levelOffsets,
+                 std::vector<std::int64_t> levelTexels, PageCache &cache);
+
+    // @param index The texel's index within its level (see MipLevel::index).
+    RGBA texel(int level, int index) const;
+
+private:
+    PageCache::Page loadPage(int level, int page) const;
+
+    std::uint64_t m_id; // distinguishes this texture's pages in the shared cache
+    std::vector<std::int64_t> m_levelOffsets;
+    std::vector<std::int64_t> m_levelTexels;
+    PageCache &m_cache;
+
+    mutable QFile m_file;
+    mutable std::mutex m_fileMutex;
+};
+
+// Writes the image's mip chain as a texture file
+bool writeTextureFile(const QString &path, const Image &image);
+
+// Opens a texture file for paged reading. The returned image has the size of every level, but no
+// texels of its own: lookups read them through image.pages.
+// @return The image, or nullptr if the file is missing or not a texture file.
+Image* openTextureFile(const QString &path, PageCache &cache);
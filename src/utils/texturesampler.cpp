@@ -0,0 +1,114 @@
+#include "texturesampler.h"
+#include "texturecompression.h"
+#include "texturepager.h"
+
+#include <algorithm>
+#include <cmath>
+
+// Helper function to convert a texel to a color between 0 and 1
+glm::vec3 texelColor(const RGBA &texel) {
+    return glm::vec3(texel.r / 255.0f, texel.g / 255.0f, texel.b / 255.0f);
+}
+
+// Helper function to read a texel of a level, from memory (decoding a compressed one), its atlas or, for a
+// streamed texture, its pages
+RGBA fetchTexel(const Image &image, int level, int x, int y) {
+    if (image.atlas != nullptr) {
+        return fetchTexel(*image.atlas, level, (image.atlasX >> level) + x, (image.atlasY >> level) + y);
+    }
+    if (image.pages != nullptr) {
+        return image.pages->texel(level, image.levels[level].index(x, y));
+    }
+    if (image.format != TextureFormat::RGBA8) {
+        return compressedTexel(image, image.levels[level], x, y);
+    }
+    return image.levels[level].texel(x, y);
+}
+
+// Helper function to make an empty level in the tiled layout
+MipLevel makeLevel(int width, int height) {
+    int tilesX = (width + 7) / 8;
+    int tilesY = (height + 7) / 8;
+    return MipLevel{width, height, tilesX, std::vector<RGBA>(tilesX * tilesY * 64)};
+}
+
+void buildMipChain(Image &image, const RGBA *rows) {
+    image.levels.clear();
+
+    MipLevel base = makeLevel(image.width, image.height);
+    for (int y = 0; y < image.height; y++) {
+        for (int x = 0; x < image.width; x++) {
+            base.texel(x, y) = rows[y * image.width + x];
+        }
+    }
+    image.levels.push_back(std::move(base));
+
+    while (image.levels.back().width > 1 || image.levels.back().height > 1) {
+        const MipLevel &below = image.levels.back();
+        MipLevel level = makeLevel(std::max(below.width / 2, 1), std::max(below.height / 2, 1));
+
+        for (int y = 0; y < level.height; y++) {
+            for (int x = 0; x < level.width; x++) {
+                int x0 = std::min(2 * x, below.width - 1), x1 = std::min(2 * x + 1, below.width - 1);
+                int y0 = std::min(2 * y, below.height - 1), y1 = std::min(2 * y + 1, below.height - 1);
+                const RGBA &a = below.texel(x0, y0);
+                const RGBA &b = below.texel(x1, y0);
+                const RGBA &c = below.texel(x0, y1);
+                const RGBA &d = below.texel(x1, y1);
+                level.texel(x, y) = RGBA{static_cast<std::uint8_t>((a.r + b.r + c.r + d.r + 2) / 4),
+                                         static_cast<std::uint8_t>((a.g + b.g + c.g + d.g + 2) / 4),
+                                         static_cast<std::uint8_t>((a.b + b.b + c.b + d.b + 2) / 4),
+                                         255};
+            }
+        }
+        image.levels.push_back(std::move(level));
+    }
+}
+
+// Helper function to sample a mip level bilinearly, wrapping around its edges.
+// (s, t) are in repetitions of the image, t going down.
+glm::vec3 sampleBilinear(const Image &image, int levelIndex, float s, float t) {
+    const MipLevel &level = image.levels[levelIndex];
+    float x = s * level.width - 0.5f;
+    float y = t * level.height - 0.5f;
+    float fx = std::floor(x);
+    float fy = std::floor(y);
+    float ax = x - fx;
+    float ay = y - fy;
+
+    auto wrap = [](int i, int n) { return ((i % n) + n) % n; };
+    int x0 = wrap(static_cast<int>(fx), level.width), x1 = wrap(static_cast<int>(fx) + 1, level.width);
+    int y0 = wrap(static_cast<int>(fy), level.height), y1 = wrap(static_cast<int>(fy) + 1, level.height);
+
+    glm::vec3 top = glm::mix(texelColor(fetchTexel(image, levelIndex, x0, y0)), texelColor(fetchTexel(image, levelIndex, x1, y0)), ax);
+    glm::vec3 bottom = glm::mix(texelColor(fetchTexel(image, levelIndex, x0, y1)), texelColor(fetchTexel(image, levelIndex, x1, y1)), ax);
+    return glm::mix(top, bottom, ay);
+}
+
+glm::vec3 sampleTexture(const Image &image, const SceneFileMap &textureMap, float u, float v, float footprint) {
+    if (footprint <= 0.0f) {
+        int x = static_cast<int>(std::floor(u * textureMap.repeatU * image.width)) % image.width;
+        int y = static_cast<int>(std::floor((1 - v) * textureMap.repeatV * image.height)) % image.height;
+
+        // the far edge wraps to the last texel of the last repetition
+        if (u == 1.0f) x = static_cast<int>(textureMap.repeatU * image.width - 1) % image.width;
+        if (v == 0.0f) y = static_cast<int>(textureMap.repeatV * image.height - 1) % image.height;
+
+        return texelColor(fetchTexel(image, 0, x, y));
+    }
+
+    float s = u * textureMap.repeatU;
+    float t = (1 - v) * textureMap.repeatV;
+
+    // the footprint's size in texels of the full-resolution image picks the level
+    float texels = footprint * std::max(textureMap.repeatU * image.width, textureMap.repeatV * image.height);
+    float lod = std::clamp(std::log2(std::max(texels, 1e-6f)), 0.0f, static_cast<float>(image.levels.size() - 1));
+
+    int lower = static_cast<int>(lod);
+    int upper = std::min(lower + 1, static_cast<int>(image.levels.size()) - 1);
+    glm::vec3 color = sampleBilinear(image, lower, s, t);
+    if (upper == lower || lod == lower) {
+        return color;
+    }
+    return glm::mix(color, sampleBilinear(image, upper, s, t), lod - lower);
+}
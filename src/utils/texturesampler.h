@@ -0,0 +1,22 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include "imagereader.h"
+#include "scenedata.h"
+
+// Texture lookups shared by every shape. A shape maps its hit point to (u, v) in [0, 1], with v
+// going up, and the texture map's repeatU/repeatV tile the image across that range.
+//
+// Without a footprint the texel under (u, v) is returned as is. With one, the lookup is filtered
+// trilinearly: the footprint picks the pair of mip levels whose texels are about its size, and
+// each level is sampled bilinearly, so distant textures read small, averaged levels instead of
+// aliasing across the full-resolution image.
+
+// Builds the image's mip chain from its texels in row-major order: level 0 holds them in the tiled
+// layout (see MipLevel), each further level is half the size of the previous one (rounded down, at
+// least 1x1), each texel the average of the up to 2x2 texels below it. Called once at load time.
+void buildMipChain(Image &image, const RGBA *rows);
+
+// @param footprint The width a pixel covers on the surface around (u, v), in units of (u, v),
+//                  or 0 for an unfiltered lookup.
+glm::vec3 sampleTexture(const Image &image, const SceneFileMap &textureMap, float u, float v, float footprint);
@@ -0,0 +1,115 @@
+#include "tracelog.h"
+
+#include <QFile>
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace TraceLog {
+
+struct Event {
+    const char *name;
+    const char *category;
+    std::string args;
+    int thread;
+    double start;    // microseconds since start()
+    double duration; // microseconds
+};
+
+std::atomic<bool> enabled = false;
+std::chrono::steady_clock::time_point origin;
+std::mutex mutex;
+std::vector<Event> events;
+std::atomic<int> threadCount = 0;
+
+// Helper function returning a small id of the calling thread, handed out in the order threads first record
+int threadId() {
+    static thread_local int id = threadCount++;
+    return id;
+}
+
+// Helper function to escape a string for a JSON string literal
+std::string escape(const std::string &text) {
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+std::string quote(const std::string &text) {
+    return "\"" + escape(text) + "\"";
+}
+
+void start() {
+    std::lock_guard<std::mutex> lock(mutex);
+    events.clear();
+    origin = std::chrono::steady_clock::now();
+    enabled = true;
+}
+
+bool isEnabled() {
+    return enabled;
+}
+
+bool write(const QString &path) {
+    std::ostringstream json;
+    json << std::fixed << std::setprecision(3);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        json << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+        for (int i = 0; i < threadCount; i++) {
+            json << (i > 0 ? "," : "") << "\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << i
+                 << ", \"args\": {\"name\": \"thread " << i << "\"}}";
+        }
+        for (const Event &event : events) {
+            json << ",\n{\"name\": \"" << escape(event.name) << "\", \"cat\": \"" << escape(event.category)
+                 << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << event.thread
+                 << ", \"ts\": " << event.start << ", \"dur\": " << event.duration;
+            if (!event.args.empty()) {
+                json << ", \"args\": " << event.args;
+            }
+            json << "}";
+        }
+        json << "\n]}\n";
+    }
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        std::cerr << "Error: could not write trace to \"" << path.toStdString() << "\"" << std::endl;
+        return false;
+    }
+    file.write(QByteArray::fromStdString(json.str()));
+    std::cout << "Saved trace to \"" << path.toStdString() << "\"" << std::endl;
+    return true;
+}
+
+Span::Span(const char *name, const char *category, const std::string &args)
+    : m_name(name), m_category(category), m_enabled(enabled)
+{
+    if (m_enabled) {
+        m_args = args;
+        m_start = std::chrono::steady_clock::now();
+    }
+}
+
+Span::~Span() {
+    if (!m_enabled) {
+        return;
+    }
+    auto end = std::chrono::steady_clock::now();
+    int thread = threadId();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    events.push_back(Event{m_name, m_category, std::move(m_args), thread,
+                           std::chrono::duration<double, std::micro>(m_start - origin).count(),
+                           std::chrono::duration<double, std::micro>(end - m_start).count()});
+}
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <QString>
+#include <chrono>
+#include <string>
+
+// A timeline of the renderer's phases in Chrome's trace event format, for chrome://tracing or Perfetto.
+// Nothing is recorded until start() is called (projects_ray_cli --trace), so the spans cost a single
+// flag check otherwise. Each thread shows up as its own row, named after the order it first recorded in.
+
+namespace TraceLog {
+
+// Starts recording spans from every thread
+void start();
+
+// Whether spans are being recorded
+bool isEnabled();
+
+// Writes every span recorded so far as a JSON trace to path
+bool write(const QString &path);
+
+// Returns text as a JSON string literal, for the args of a span
+std::string quote(const std::string &text);
+
+// A span covering the time until it goes out of scope, shown on the calling thread's row.
+// name and category must outlive the span (string literals do).
+class Span
+{
+public:
+    // @param args A JSON object of extra details shown with the span, or empty.
+    Span(const char *name, const char *category, const std::string &args = "");
+    ~Span();
+
+private:
+    const char *m_name;
+    const char *m_category;
+    std::string m_args;
+    bool m_enabled;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+}